@@ -0,0 +1,756 @@
+/*
+Copyright 2004-2023 Tom Rothamel <pytom@bishoujo.us>
+
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation files
+(the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge,
+publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/* This encodes frames captured from the screen and the audio mixer to a
+ * video file. The frames are copied into a queue by the caller, and then
+ * converted and encoded on a background thread, so the game doesn't have to
+ * wait for the encoder. Audio is copied into a preallocated ring buffer, as
+ * it comes from the audio callback, which can't allocate or wait on a lock. */
+
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libswresample/swresample.h>
+#include <libswscale/swscale.h>
+#include <libavutil/audio_fifo.h>
+
+#include <SDL.h>
+#include <SDL_thread.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+/* The number of bytes in a stereo sample of 16-bit audio. */
+#define AUDIO_BPS 4
+
+/* The number of seconds of audio the ring buffer can hold. If the encoder
+ * falls further behind than this, audio is dropped. */
+#define AUDIO_RING_SECONDS 2
+
+typedef struct EncodeItem {
+    struct EncodeItem *next;
+
+    /* The frame number. */
+    int64_t frame;
+
+    /* The size and pitch of the RGBA pixels. */
+    int width;
+    int height;
+    int pitch;
+
+    uint8_t *data;
+} EncodeItem;
+
+typedef struct EncodeState {
+
+    /* Protects the queue and the counts below. The audio ring buffer is
+     * not protected by this lock. */
+    SDL_mutex *lock;
+
+    /* Signalled when an item is queued, or an item is taken off the queue. */
+    SDL_cond *cond;
+
+    SDL_Thread *thread;
+
+    EncodeItem *queue_head;
+    EncodeItem *queue_tail;
+
+    /* The number of video frames in the queue, and the most allowed. */
+    int queued_frames;
+    int max_queued_frames;
+
+    /* The number of video frames that were dropped because the queue was
+     * full. */
+    int dropped_frames;
+
+    /* Set to make the encoding thread finish. */
+    int quit;
+
+    /* Set if encoding failed. */
+    int failed;
+
+    AVFormatContext *ctx;
+
+    AVStream *video_stream;
+    AVCodecContext *video_context;
+    AVFrame *video_frame;
+    struct SwsContext *sws;
+    int sws_width;
+    int sws_height;
+
+    AVStream *audio_stream;
+    AVCodecContext *audio_context;
+    AVFrame *audio_frame;
+    SwrContext *swr;
+    AVAudioFifo *audio_fifo;
+    int64_t audio_pts;
+
+    /* The sample rate of the audio given to encode_audio. */
+    int audio_freq;
+
+    /* A ring buffer of stereo samples, written by encode_audio and read by
+     * the encoding thread. The size is a power of two, and the positions
+     * are counts of samples that wrap around, so the number of samples in
+     * the ring is audio_write - audio_read. */
+    short *audio_ring;
+    unsigned int audio_ring_size;
+    SDL_atomic_t audio_write;
+    SDL_atomic_t audio_read;
+
+} EncodeState;
+
+
+/* Queueing *******************************************************************/
+
+static void enqueue_item(EncodeState *es, EncodeItem *item) {
+    item->next = NULL;
+
+    if (es->queue_tail) {
+        es->queue_tail->next = item;
+    } else {
+        es->queue_head = item;
+    }
+
+    es->queue_tail = item;
+    es->queued_frames += 1;
+
+    SDL_CondBroadcast(es->cond);
+}
+
+static EncodeItem *dequeue_item(EncodeState *es) {
+    EncodeItem *rv = es->queue_head;
+
+    if (!rv) {
+        return NULL;
+    }
+
+    es->queue_head = rv->next;
+
+    if (!es->queue_head) {
+        es->queue_tail = NULL;
+    }
+
+    es->queued_frames -= 1;
+
+    SDL_CondBroadcast(es->cond);
+
+    return rv;
+}
+
+static void free_item(EncodeItem *item) {
+    av_free(item->data);
+    av_free(item);
+}
+
+
+/* Encoding *******************************************************************/
+
+/* Sends `frame` (or NULL, to flush) to the encoder, and writes the packets
+ * that come out of it to the file. */
+static int write_frame(EncodeState *es, AVCodecContext *cc, AVStream *st, AVFrame *frame) {
+    int ret;
+
+    ret = avcodec_send_frame(cc, frame);
+
+    if (ret < 0) {
+        return ret;
+    }
+
+    AVPacket *pkt = av_packet_alloc();
+
+    if (!pkt) {
+        return AVERROR(ENOMEM);
+    }
+
+    while (1) {
+        ret = avcodec_receive_packet(cc, pkt);
+
+        if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
+            ret = 0;
+            break;
+        }
+
+        if (ret < 0) {
+            break;
+        }
+
+        av_packet_rescale_ts(pkt, cc->time_base, st->time_base);
+        pkt->stream_index = st->index;
+
+        ret = av_interleaved_write_frame(es->ctx, pkt);
+
+        if (ret < 0) {
+            break;
+        }
+    }
+
+    av_packet_free(&pkt);
+    return ret;
+}
+
+static void encode_video_item(EncodeState *es, EncodeItem *item) {
+
+    if (!es->video_context) {
+        return;
+    }
+
+    AVFrame *f = es->video_frame;
+
+    if (!es->sws || es->sws_width != item->width || es->sws_height != item->height) {
+        sws_freeContext(es->sws);
+
+        es->sws = sws_getContext(
+            item->width, item->height, AV_PIX_FMT_RGBA,
+            f->width, f->height, f->format,
+            SWS_BICUBIC, NULL, NULL, NULL);
+
+        es->sws_width = item->width;
+        es->sws_height = item->height;
+    }
+
+    if (!es->sws || av_frame_make_writable(f) < 0) {
+        es->failed = 1;
+        return;
+    }
+
+    const uint8_t *src[1] = { item->data };
+    int src_pitch[1] = { item->pitch };
+
+    sws_scale(es->sws, src, src_pitch, 0, item->height, f->data, f->linesize);
+
+    f->pts = item->frame;
+
+    if (write_frame(es, es->video_context, es->video_stream, f) < 0) {
+        es->failed = 1;
+    }
+}
+
+/* Encodes as many full audio frames as there are in the fifo. If `flush`
+ * is true, encodes a final partial frame as well. */
+static void encode_audio_fifo(EncodeState *es, int flush) {
+    AVFrame *f = es->audio_frame;
+
+    while (av_audio_fifo_size(es->audio_fifo) >= f->nb_samples || (flush && av_audio_fifo_size(es->audio_fifo) > 0)) {
+
+        if (av_frame_make_writable(f) < 0) {
+            es->failed = 1;
+            return;
+        }
+
+        int count = av_audio_fifo_read(es->audio_fifo, (void **) f->data, f->nb_samples);
+
+        if (count < f->nb_samples) {
+            av_samples_set_silence(f->data, count, f->nb_samples - count, es->audio_context->channels, f->format);
+        }
+
+        f->pts = es->audio_pts;
+        es->audio_pts += f->nb_samples;
+
+        if (write_frame(es, es->audio_context, es->audio_stream, f) < 0) {
+            es->failed = 1;
+            return;
+        }
+    }
+}
+
+/* Converts `samples` stereo samples at `data`, and encodes them. */
+static void encode_audio_samples(EncodeState *es, const short *data, int samples) {
+
+    int out_samples = swr_get_out_samples(es->swr, samples);
+    uint8_t **converted = NULL;
+
+    if (av_samples_alloc_array_and_samples(&converted, NULL, es->audio_context->channels, out_samples, es->audio_context->sample_fmt, 0) < 0) {
+        es->failed = 1;
+        return;
+    }
+
+    const uint8_t *in[1] = { (const uint8_t *) data };
+    int count = swr_convert(es->swr, converted, out_samples, in, samples);
+
+    if (count > 0) {
+        av_audio_fifo_write(es->audio_fifo, (void **) converted, count);
+    }
+
+    av_freep(&converted[0]);
+    av_freep(&converted);
+
+    encode_audio_fifo(es, 0);
+}
+
+/* Returns the number of samples in the audio ring buffer. */
+static unsigned int audio_ring_used(EncodeState *es) {
+    unsigned int write = (unsigned int) SDL_AtomicGet(&es->audio_write);
+    unsigned int read = (unsigned int) SDL_AtomicGet(&es->audio_read);
+
+    return write - read;
+}
+
+/* Encodes the audio that's in the ring buffer, or discards it if encoding
+ * has failed. */
+static void encode_audio_ring(EncodeState *es) {
+
+    if (!es->audio_context) {
+        return;
+    }
+
+    unsigned int read = (unsigned int) SDL_AtomicGet(&es->audio_read);
+    unsigned int used = audio_ring_used(es);
+
+    SDL_MemoryBarrierAcquire();
+
+    while (used) {
+        unsigned int start = read & (es->audio_ring_size - 1);
+        unsigned int count = es->audio_ring_size - start;
+
+        if (count > used) {
+            count = used;
+        }
+
+        if (!es->failed) {
+            encode_audio_samples(es, es->audio_ring + start * 2, count);
+        }
+
+        read += count;
+        used -= count;
+    }
+
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&es->audio_read, (int) read);
+}
+
+static int encode_thread(void *arg) {
+    EncodeState *es = (EncodeState *) arg;
+
+    while (1) {
+
+        SDL_LockMutex(es->lock);
+
+        // The audio callback doesn't signal the condition, so this wakes
+        // up periodically to encode the audio in the ring buffer.
+        while (!es->queue_head && !es->quit && !audio_ring_used(es)) {
+            SDL_CondWaitTimeout(es->cond, es->lock, 20);
+        }
+
+        EncodeItem *item = dequeue_item(es);
+        int quit = es->quit;
+
+        SDL_UnlockMutex(es->lock);
+
+        encode_audio_ring(es);
+
+        if (item) {
+            if (!es->failed) {
+                encode_video_item(es, item);
+            }
+
+            free_item(item);
+
+        } else if (quit) {
+            break;
+        }
+    }
+
+    // Flush the encoders, and finish the file.
+    if (!es->failed) {
+
+        encode_audio_ring(es);
+
+        if (es->audio_context) {
+            encode_audio_fifo(es, 1);
+            write_frame(es, es->audio_context, es->audio_stream, NULL);
+        }
+
+        if (es->video_context) {
+            write_frame(es, es->video_context, es->video_stream, NULL);
+        }
+
+        av_write_trailer(es->ctx);
+    }
+
+    return 0;
+}
+
+
+/* Setup **********************************************************************/
+
+static AVCodecContext *open_video(EncodeState *es, const AVCodec *codec, int width, int height, int fps) {
+    AVCodecContext *cc = avcodec_alloc_context3(codec);
+
+    if (!cc) {
+        return NULL;
+    }
+
+    // Most encoders require an even size.
+    cc->width = width & ~1;
+    cc->height = height & ~1;
+    cc->time_base = (AVRational) { 1, fps };
+    cc->framerate = (AVRational) { fps, 1 };
+    cc->gop_size = fps;
+    cc->pix_fmt = AV_PIX_FMT_YUV420P;
+
+    if (codec->pix_fmts) {
+        cc->pix_fmt = codec->pix_fmts[0];
+    }
+
+    // Let the encoder use a pool of threads of its choosing.
+    cc->thread_count = 0;
+
+    if (es->ctx->oformat->flags & AVFMT_GLOBALHEADER) {
+        cc->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+    }
+
+    if (avcodec_open2(cc, codec, NULL) < 0) {
+        avcodec_free_context(&cc);
+        return NULL;
+    }
+
+    es->video_frame = av_frame_alloc();
+
+    if (!es->video_frame) {
+        avcodec_free_context(&cc);
+        return NULL;
+    }
+
+    es->video_frame->format = cc->pix_fmt;
+    es->video_frame->width = cc->width;
+    es->video_frame->height = cc->height;
+
+    if (av_frame_get_buffer(es->video_frame, 0) < 0) {
+        avcodec_free_context(&cc);
+        return NULL;
+    }
+
+    return cc;
+}
+
+static AVCodecContext *open_audio(EncodeState *es, const AVCodec *codec, int freq) {
+    AVCodecContext *cc = avcodec_alloc_context3(codec);
+
+    if (!cc) {
+        return NULL;
+    }
+
+    cc->sample_fmt = AV_SAMPLE_FMT_S16;
+
+    if (codec->sample_fmts) {
+        cc->sample_fmt = codec->sample_fmts[0];
+    }
+
+    cc->sample_rate = freq;
+    cc->channel_layout = AV_CH_LAYOUT_STEREO;
+    cc->channels = 2;
+    cc->bit_rate = 192000;
+    cc->time_base = (AVRational) { 1, freq };
+
+    if (es->ctx->oformat->flags & AVFMT_GLOBALHEADER) {
+        cc->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+    }
+
+    if (avcodec_open2(cc, codec, NULL) < 0) {
+        avcodec_free_context(&cc);
+        return NULL;
+    }
+
+    es->swr = swr_alloc_set_opts(
+        NULL,
+        cc->channel_layout,
+        cc->sample_fmt,
+        cc->sample_rate,
+        AV_CH_LAYOUT_STEREO,
+        AV_SAMPLE_FMT_S16,
+        freq,
+        0,
+        NULL);
+
+    if (!es->swr || swr_init(es->swr) < 0) {
+        avcodec_free_context(&cc);
+        return NULL;
+    }
+
+    es->audio_fifo = av_audio_fifo_alloc(cc->sample_fmt, cc->channels, freq);
+    es->audio_frame = av_frame_alloc();
+
+    if (!es->audio_fifo || !es->audio_frame) {
+        avcodec_free_context(&cc);
+        return NULL;
+    }
+
+    es->audio_frame->format = cc->sample_fmt;
+    es->audio_frame->channel_layout = cc->channel_layout;
+    es->audio_frame->sample_rate = cc->sample_rate;
+
+    if (cc->codec->capabilities & AV_CODEC_CAP_VARIABLE_FRAME_SIZE || !cc->frame_size) {
+        es->audio_frame->nb_samples = 1024;
+    } else {
+        es->audio_frame->nb_samples = cc->frame_size;
+    }
+
+    if (av_frame_get_buffer(es->audio_frame, 0) < 0) {
+        avcodec_free_context(&cc);
+        return NULL;
+    }
+
+    return cc;
+}
+
+static void deallocate(EncodeState *es) {
+    EncodeItem *item;
+
+    while ((item = dequeue_item(es))) {
+        free_item(item);
+    }
+
+    avcodec_free_context(&es->video_context);
+    avcodec_free_context(&es->audio_context);
+    av_frame_free(&es->video_frame);
+    av_frame_free(&es->audio_frame);
+    sws_freeContext(es->sws);
+    swr_free(&es->swr);
+
+    if (es->audio_fifo) {
+        av_audio_fifo_free(es->audio_fifo);
+    }
+
+    av_free(es->audio_ring);
+
+    if (es->ctx) {
+        if (!(es->ctx->oformat->flags & AVFMT_NOFILE)) {
+            avio_closep(&es->ctx->pb);
+        }
+
+        avformat_free_context(es->ctx);
+    }
+
+    SDL_DestroyCond(es->cond);
+    SDL_DestroyMutex(es->lock);
+
+    av_free(es);
+}
+
+/* Opens `filename` for encoding. The format and codecs are chosen based on
+ * the extension of the file. Returns NULL on failure. */
+EncodeState *encode_open(const char *filename, int width, int height, int fps, int audio_freq, int max_queued_frames) {
+
+    EncodeState *es = av_calloc(1, sizeof(EncodeState));
+
+    if (!es) {
+        return NULL;
+    }
+
+    es->lock = SDL_CreateMutex();
+    es->cond = SDL_CreateCond();
+    es->max_queued_frames = max_queued_frames;
+    es->audio_freq = audio_freq;
+
+    if (avformat_alloc_output_context2(&es->ctx, NULL, NULL, filename) < 0) {
+        goto fail;
+    }
+
+    const AVOutputFormat *fmt = es->ctx->oformat;
+
+    const AVCodec *video_codec = avcodec_find_encoder(fmt->video_codec);
+
+    if (!video_codec) {
+        video_codec = avcodec_find_encoder(AV_CODEC_ID_MPEG4);
+    }
+
+    if (!video_codec) {
+        goto fail;
+    }
+
+    es->video_stream = avformat_new_stream(es->ctx, NULL);
+    es->video_context = open_video(es, video_codec, width, height, fps);
+
+    if (!es->video_stream || !es->video_context) {
+        goto fail;
+    }
+
+    es->video_stream->time_base = es->video_context->time_base;
+    avcodec_parameters_from_context(es->video_stream->codecpar, es->video_context);
+
+    // Audio is optional - without an encoder, the video is silent.
+    const AVCodec *audio_codec = NULL;
+
+    if (audio_freq && fmt->audio_codec != AV_CODEC_ID_NONE) {
+        audio_codec = avcodec_find_encoder(fmt->audio_codec);
+    }
+
+    if (audio_codec) {
+        es->audio_stream = avformat_new_stream(es->ctx, NULL);
+        es->audio_context = open_audio(es, audio_codec, audio_freq);
+
+        if (!es->audio_stream || !es->audio_context) {
+            goto fail;
+        }
+
+        es->audio_stream->time_base = es->audio_context->time_base;
+        avcodec_parameters_from_context(es->audio_stream->codecpar, es->audio_context);
+
+        es->audio_ring_size = 1;
+
+        while (es->audio_ring_size < (unsigned int) (audio_freq * AUDIO_RING_SECONDS)) {
+            es->audio_ring_size *= 2;
+        }
+
+        es->audio_ring = av_malloc(es->audio_ring_size * AUDIO_BPS);
+
+        if (!es->audio_ring) {
+            goto fail;
+        }
+    }
+
+    if (!(fmt->flags & AVFMT_NOFILE)) {
+        if (avio_open(&es->ctx->pb, filename, AVIO_FLAG_WRITE) < 0) {
+            goto fail;
+        }
+    }
+
+    if (avformat_write_header(es->ctx, NULL) < 0) {
+        goto fail;
+    }
+
+    es->thread = SDL_CreateThread(encode_thread, "encode_thread", (void *) es);
+
+    if (!es->thread) {
+        goto fail;
+    }
+
+    return es;
+
+fail:
+    deallocate(es);
+    return NULL;
+}
+
+/* Copies a frame of RGBA pixels into the queue. If the queue is full, this
+ * either waits for it to drain (if `block` is true), or drops the frame.
+ * Returns 1 if the frame was queued, 0 if it was dropped. */
+int encode_video(EncodeState *es, const uint8_t *pixels, int width, int height, int pitch, int64_t frame, int block) {
+
+    SDL_LockMutex(es->lock);
+
+    while (block && es->queued_frames >= es->max_queued_frames && !es->failed) {
+        SDL_CondWait(es->cond, es->lock);
+    }
+
+    if (es->queued_frames >= es->max_queued_frames || es->failed) {
+        es->dropped_frames += 1;
+        SDL_UnlockMutex(es->lock);
+        return 0;
+    }
+
+    SDL_UnlockMutex(es->lock);
+
+    EncodeItem *item = av_mallocz(sizeof(EncodeItem));
+
+    if (!item) {
+        return 0;
+    }
+
+    item->frame = frame;
+    item->width = width;
+    item->height = height;
+    item->pitch = width * 4;
+    item->data = av_malloc(item->pitch * height);
+
+    if (!item->data) {
+        av_free(item);
+        return 0;
+    }
+
+    for (int y = 0; y < height; y++) {
+        memcpy(item->data + y * item->pitch, pixels + y * pitch, item->pitch);
+    }
+
+    SDL_LockMutex(es->lock);
+    enqueue_item(es, item);
+    SDL_UnlockMutex(es->lock);
+
+    return 1;
+}
+
+/* Copies `count` stereo 16-bit samples into the audio ring buffer. This is
+ * called from the audio callback, and so doesn't allocate memory or take a
+ * lock. If the ring buffer is full, the samples that don't fit are dropped. */
+void encode_audio(EncodeState *es, const short *samples, int count) {
+
+    if (!es->audio_context || count <= 0) {
+        return;
+    }
+
+    unsigned int write = (unsigned int) SDL_AtomicGet(&es->audio_write);
+    unsigned int space = es->audio_ring_size - audio_ring_used(es);
+
+    SDL_MemoryBarrierAcquire();
+
+    if ((unsigned int) count > space) {
+        count = space;
+    }
+
+    while (count > 0) {
+        unsigned int start = write & (es->audio_ring_size - 1);
+        unsigned int n = es->audio_ring_size - start;
+
+        if (n > (unsigned int) count) {
+            n = count;
+        }
+
+        memcpy(es->audio_ring + start * 2, samples, n * AUDIO_BPS);
+
+        samples += n * 2;
+        write += n;
+        count -= n;
+    }
+
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&es->audio_write, (int) write);
+}
+
+/* Returns the number of frames dropped so far. */
+int encode_dropped_frames(EncodeState *es) {
+    int rv;
+
+    SDL_LockMutex(es->lock);
+    rv = es->dropped_frames;
+    SDL_UnlockMutex(es->lock);
+
+    return rv;
+}
+
+/* Finishes encoding everything in the queue, closes the file, and frees
+ * `es`. Returns 0 on success, or -1 if encoding failed at some point. */
+int encode_close(EncodeState *es) {
+    int rv;
+
+    SDL_LockMutex(es->lock);
+    es->quit = 1;
+    SDL_CondBroadcast(es->cond);
+    SDL_UnlockMutex(es->lock);
+
+    SDL_WaitThread(es->thread, NULL);
+
+    rv = es->failed ? -1 : 0;
+
+    deallocate(es);
+
+    return rv;
+}
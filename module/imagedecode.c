@@ -0,0 +1,334 @@
+#include "imagedecode.h"
+
+#include <png.h>
+#include <setjmp.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef HAVE_TURBOJPEG
+#include <turbojpeg.h>
+#endif
+
+#ifdef HAVE_WEBP
+#include <webp/decode.h>
+#endif
+
+/* This decodes PNG, JPEG, and WebP images from memory directly into a
+ * caller-supplied buffer of RGBA pixels, with rows `pitch` bytes apart.
+ * None of these functions use Python, so they can be called with the
+ * GIL released. Each returns 0 on success, and -1 if the image can't be
+ * decoded, in which case the caller should fall back to SDL_image.
+ */
+
+int imagedecode_format(const unsigned char *data, size_t length) {
+    if (length >= 8 && !png_sig_cmp((png_const_bytep) data, 0, 8)) {
+        return IMAGEDECODE_PNG;
+    }
+
+    if (length >= 3 && data[0] == 0xff && data[1] == 0xd8 && data[2] == 0xff) {
+        return IMAGEDECODE_JPEG;
+    }
+
+    if (length >= 12 && !memcmp(data, "RIFF", 4) && !memcmp(data + 8, "WEBP", 4)) {
+        return IMAGEDECODE_WEBP;
+    }
+
+    return IMAGEDECODE_UNKNOWN;
+}
+
+int imagedecode_supported(int format) {
+    switch (format) {
+        case IMAGEDECODE_PNG:
+            return 1;
+
+#ifdef HAVE_TURBOJPEG
+        case IMAGEDECODE_JPEG:
+            return 1;
+#endif
+
+#ifdef HAVE_WEBP
+        case IMAGEDECODE_WEBP:
+            return 1;
+#endif
+
+        default:
+            return 0;
+    }
+}
+
+
+/* PNG ***********************************************************************/
+
+struct memory_source {
+    const unsigned char *data;
+    size_t length;
+    size_t offset;
+};
+
+static void read_memory(png_structp png, png_bytep out, png_size_t count) {
+    struct memory_source *source = (struct memory_source *) png_get_io_ptr(png);
+
+    if (count > source->length - source->offset) {
+        png_error(png, "Read past the end of the image.");
+    }
+
+    memcpy(out, source->data + source->offset, count);
+    source->offset += count;
+}
+
+/* Errors longjmp out of the decode, so there's nothing to print. */
+static void ignore_warning(png_structp png, png_const_charp message) {
+}
+
+/* Opens a PNG and reads its header, setting up the transformations that
+ * produce 8-bit RGBA. Returns 0 on success.
+ */
+static int open_png(png_structp png, png_infop info, struct memory_source *source) {
+    int color_type;
+    int bit_depth;
+
+    png_set_read_fn(png, source, read_memory);
+    png_read_info(png, info);
+
+    color_type = png_get_color_type(png, info);
+    bit_depth = png_get_bit_depth(png, info);
+
+    if (color_type == PNG_COLOR_TYPE_PALETTE) {
+        png_set_palette_to_rgb(png);
+    }
+
+    if (color_type == PNG_COLOR_TYPE_GRAY && bit_depth < 8) {
+        png_set_expand_gray_1_2_4_to_8(png);
+    }
+
+    if (png_get_valid(png, info, PNG_INFO_tRNS)) {
+        png_set_tRNS_to_alpha(png);
+    } else if (!(color_type & PNG_COLOR_MASK_ALPHA)) {
+        png_set_filler(png, 0xff, PNG_FILLER_AFTER);
+    }
+
+    if (bit_depth == 16) {
+        png_set_strip_16(png);
+    }
+
+    if (color_type == PNG_COLOR_TYPE_GRAY || color_type == PNG_COLOR_TYPE_GRAY_ALPHA) {
+        png_set_gray_to_rgb(png);
+    }
+
+    png_set_interlace_handling(png);
+    png_read_update_info(png, info);
+
+    return 0;
+}
+
+static int info_png(const unsigned char *data, size_t length, int *width, int *height) {
+    struct memory_source source = { data, length, 0 };
+    png_structp png;
+    png_infop info;
+
+    png = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, ignore_warning);
+    if (!png) {
+        return -1;
+    }
+
+    info = png_create_info_struct(png);
+    if (!info) {
+        png_destroy_read_struct(&png, NULL, NULL);
+        return -1;
+    }
+
+    if (setjmp(png_jmpbuf(png))) {
+        png_destroy_read_struct(&png, &info, NULL);
+        return -1;
+    }
+
+    png_set_read_fn(png, &source, read_memory);
+    png_read_info(png, info);
+
+    *width = png_get_image_width(png, info);
+    *height = png_get_image_height(png, info);
+
+    png_destroy_read_struct(&png, &info, NULL);
+    return 0;
+}
+
+static int decode_png(const unsigned char *data, size_t length, unsigned char *pixels, int pitch, int width, int height) {
+    struct memory_source source = { data, length, 0 };
+    png_structp png;
+    png_infop info;
+    png_bytep * volatile rows = NULL;
+    int y;
+
+    png = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, ignore_warning);
+    if (!png) {
+        return -1;
+    }
+
+    info = png_create_info_struct(png);
+    if (!info) {
+        png_destroy_read_struct(&png, NULL, NULL);
+        return -1;
+    }
+
+    if (setjmp(png_jmpbuf(png))) {
+        free(rows);
+        png_destroy_read_struct(&png, &info, NULL);
+        return -1;
+    }
+
+    open_png(png, info, &source);
+
+    if ((int) png_get_image_width(png, info) != width ||
+        (int) png_get_image_height(png, info) != height ||
+        png_get_rowbytes(png, info) != (png_size_t) width * 4) {
+
+        png_destroy_read_struct(&png, &info, NULL);
+        return -1;
+    }
+
+    rows = (png_bytep *) malloc(sizeof(png_bytep) * height);
+    if (!rows) {
+        png_destroy_read_struct(&png, &info, NULL);
+        return -1;
+    }
+
+    for (y = 0; y < height; y++) {
+        rows[y] = pixels + (size_t) y * pitch;
+    }
+
+    png_read_image(png, rows);
+    png_read_end(png, NULL);
+
+    free(rows);
+    png_destroy_read_struct(&png, &info, NULL);
+
+    return 0;
+}
+
+
+/* JPEG **********************************************************************/
+
+#ifdef HAVE_TURBOJPEG
+
+static int info_jpeg(const unsigned char *data, size_t length, int *width, int *height) {
+    tjhandle handle;
+    int subsamp;
+    int colorspace;
+    int rv;
+
+    handle = tjInitDecompress();
+    if (!handle) {
+        return -1;
+    }
+
+    rv = tjDecompressHeader3(handle, data, (unsigned long) length, width, height, &subsamp, &colorspace);
+
+    tjDestroy(handle);
+
+    return rv ? -1 : 0;
+}
+
+static int decode_jpeg(const unsigned char *data, size_t length, unsigned char *pixels, int pitch, int width, int height) {
+    tjhandle handle;
+    int rv;
+
+    handle = tjInitDecompress();
+    if (!handle) {
+        return -1;
+    }
+
+    rv = tjDecompress2(handle, data, (unsigned long) length, pixels, width, pitch, height, TJPF_RGBA, 0);
+
+    tjDestroy(handle);
+
+    return rv ? -1 : 0;
+}
+
+#endif
+
+
+/* WebP **********************************************************************/
+
+#ifdef HAVE_WEBP
+
+static int info_webp(const unsigned char *data, size_t length, int *width, int *height) {
+    WebPBitstreamFeatures features;
+
+    if (WebPGetFeatures(data, length, &features) != VP8_STATUS_OK) {
+        return -1;
+    }
+
+    /* Animations are left to SDL_image. */
+    if (features.has_animation) {
+        return -1;
+    }
+
+    *width = features.width;
+    *height = features.height;
+
+    return 0;
+}
+
+static int decode_webp(const unsigned char *data, size_t length, unsigned char *pixels, int pitch, int width, int height) {
+    if (!WebPDecodeRGBAInto(data, length, pixels, (size_t) pitch * height, pitch)) {
+        return -1;
+    }
+
+    return 0;
+}
+
+#endif
+
+
+/* Dispatch ******************************************************************/
+
+/* Stores the size of the image in `width` and `height`. */
+int imagedecode_info(const unsigned char *data, size_t length, int *width, int *height) {
+
+    switch (imagedecode_format(data, length)) {
+        case IMAGEDECODE_PNG:
+            return info_png(data, length, width, height);
+
+#ifdef HAVE_TURBOJPEG
+        case IMAGEDECODE_JPEG:
+            return info_jpeg(data, length, width, height);
+#endif
+
+#ifdef HAVE_WEBP
+        case IMAGEDECODE_WEBP:
+            return info_webp(data, length, width, height);
+#endif
+
+        default:
+            return -1;
+    }
+}
+
+/* Decodes the image into `pixels`, which must be at least `pitch` *
+ * `height` bytes, with `width` and `height` as returned by
+ * imagedecode_info.
+ */
+int imagedecode_decode(const unsigned char *data, size_t length, unsigned char *pixels, int pitch, int width, int height) {
+
+    if (pitch < width * 4) {
+        return -1;
+    }
+
+    switch (imagedecode_format(data, length)) {
+        case IMAGEDECODE_PNG:
+            return decode_png(data, length, pixels, pitch, width, height);
+
+#ifdef HAVE_TURBOJPEG
+        case IMAGEDECODE_JPEG:
+            return decode_jpeg(data, length, pixels, pitch, width, height);
+#endif
+
+#ifdef HAVE_WEBP
+        case IMAGEDECODE_WEBP:
+            return decode_webp(data, length, pixels, pitch, width, height);
+#endif
+
+        default:
+            return -1;
+    }
+}
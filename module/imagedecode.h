@@ -0,0 +1,16 @@
+#ifndef IMAGEDECODE_H
+#define IMAGEDECODE_H
+
+#include <stddef.h>
+
+#define IMAGEDECODE_UNKNOWN 0
+#define IMAGEDECODE_PNG 1
+#define IMAGEDECODE_JPEG 2
+#define IMAGEDECODE_WEBP 3
+
+int imagedecode_format(const unsigned char *data, size_t length);
+int imagedecode_supported(int format);
+int imagedecode_info(const unsigned char *data, size_t length, int *width, int *height);
+int imagedecode_decode(const unsigned char *data, size_t length, unsigned char *pixels, int pitch, int width, int height);
+
+#endif
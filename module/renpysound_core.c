@@ -31,6 +31,15 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 SDL_mutex *name_mutex;
 
+/* This protects pending_events, and is used with event_cond to wake up
+   the thread waiting in RPS_wait_event. */
+SDL_mutex *event_mutex;
+SDL_cond *event_cond;
+
+/* A bitmask of the RPS_EVENT_* flags that have been posted, but not yet
+   returned by RPS_wait_event. */
+static int pending_events = 0;
+
 #ifdef __EMSCRIPTEN__
 
 #define LOCK_AUDIO() { }
@@ -78,6 +87,16 @@ SDL_Surface *media_read_video(struct MediaState *ms);
 double media_duration(struct MediaState *ms);
 void media_wait_ready(struct MediaState *ms);
 
+/* Declarations of ffencode functions. */
+struct EncodeState;
+typedef struct EncodeState EncodeState;
+
+EncodeState *encode_open(const char *filename, int width, int height, int fps, int audio_freq, int max_queued_frames);
+int encode_video(EncodeState *es, const Uint8 *pixels, int width, int height, int pitch, int64_t frame, int block);
+void encode_audio(EncodeState *es, const short *samples, int count);
+int encode_dropped_frames(EncodeState *es);
+int encode_close(EncodeState *es);
+
 /* Min and Max */
 #define min(a, b) (((a) < (b)) ? (a) : (b))
 #define max(a, b) (((a) > (b)) ? (a) : (b))
@@ -275,6 +294,9 @@ struct Channel {
      */
     float last_volume;
 
+    /* The bus this channel is mixed into. */
+    int bus;
+
 };
 
 struct Dying {
@@ -334,6 +356,18 @@ static void free_stream(struct MediaState *ss) {
 
 
 
+/* Posts one of the RPS_EVENT_* flags, waking the thread in RPS_wait_event. */
+static void post_periodic_event(int event) {
+
+#ifndef __EMSCRIPTEN__
+    SDL_LockMutex(event_mutex);
+    pending_events |= event;
+    SDL_CondSignal(event_cond);
+    SDL_UnlockMutex(event_mutex);
+#endif
+
+}
+
 static void post_event(struct Channel *c) {
     if (! c->event) {
         return;
@@ -383,6 +417,407 @@ static inline void mix_sample(struct Channel *c, short left_in, short right_in,
 }
 
 
+/* The encoder the mixed audio and captured frames are sent to, or NULL if
+ * we're not capturing. */
+static EncodeState *capture = NULL;
+
+/* If true, the capture is in fixed-timestep mode, and audio is mixed by
+ * RPS_capture_audio rather than the audio device. */
+static int capture_fixed = 0;
+
+
+/*
+ * Submix buses. Each channel is mixed into a bus, and each bus other than
+ * the master bus (bus 0) is mixed into its parent after its effects have
+ * been applied. The effects are applied a block at a time, in the audio
+ * callback.
+ */
+
+#define MAX_BUSES 32
+
+/* The number of comb and allpass filters in each reverb. */
+#define REVERB_COMBS 4
+#define REVERB_ALLPASSES 2
+
+/* The lengths, in samples at 44.1 kHz, of the reverb's delay lines. */
+static const int comb_lengths[REVERB_COMBS] = { 1116, 1188, 1277, 1356 };
+static const int allpass_lengths[REVERB_ALLPASSES] = { 556, 441 };
+
+/* The offset between the left and right delay lines, for stereo spread. */
+#define REVERB_SPREAD 23
+
+struct DelayLine {
+    float *buffer;
+    int length;
+    int index;
+
+    /* For combs, the state of the damping filter. */
+    float filter;
+};
+
+struct Reverb {
+    struct DelayLine comb[2][REVERB_COMBS];
+    struct DelayLine allpass[2][REVERB_ALLPASSES];
+
+    float feedback;
+    float damping;
+    float wet;
+};
+
+struct Bus {
+
+    /* The bus this bus is mixed into, or -1 for the master bus. */
+    int parent;
+
+    /* The volume of the bus, linear. */
+    struct Interpolate volume;
+
+    /* The coefficient of the two-pole low-pass filter, or 0 if the filter is
+     * disabled, and the state of each of the poles for each side. */
+    float lowpass;
+    float lowpass_state[2][2];
+
+    /* The bus whose level ducks this bus, or -1 if ducking is disabled. */
+    int duck_source;
+
+    /* The level, linear, above which ducking begins. */
+    float duck_threshold;
+
+    /* The compression ratio applied above the threshold. */
+    float duck_ratio;
+
+    /* The time constants of the ducking envelope, in seconds. */
+    float duck_attack;
+    float duck_release;
+
+    /* The envelope of the sidechain, and the gain applied in the last
+     * block. */
+    float duck_envelope;
+    float duck_gain;
+
+    /* The bus reverb is sent to, or -1 if there's no send, and the amount. */
+    int reverb_bus;
+    float reverb_send;
+
+    /* The reverb applied to this bus, if not NULL. */
+    struct Reverb *reverb;
+
+    /* The peak level of the output of the last block. */
+    float level;
+};
+
+static struct Bus buses[MAX_BUSES];
+
+/* The order buses are processed in. Every bus comes before the buses it
+ * is mixed or sent into. */
+static int bus_order[MAX_BUSES];
+
+/* The number of buses that have been used. */
+static int num_buses = 1;
+
+/* A buffer of MAX_BUSES * bus_buffer_length * 2 floats. */
+static float *bus_buffers = NULL;
+static int bus_buffer_length = 0;
+
+static void init_bus(struct Bus *b, int parent) {
+    memset(b, 0, sizeof(struct Bus));
+
+    b->parent = parent;
+    init_interpolate(&b->volume, 1.0);
+    b->duck_source = -1;
+    b->duck_gain = 1.0;
+    b->reverb_bus = -1;
+}
+
+static void free_reverb(struct Reverb *r) {
+    if (!r) {
+        return;
+    }
+
+    for (int side = 0; side < 2; side++) {
+        for (int i = 0; i < REVERB_COMBS; i++) {
+            free(r->comb[side][i].buffer);
+        }
+
+        for (int i = 0; i < REVERB_ALLPASSES; i++) {
+            free(r->allpass[side][i].buffer);
+        }
+    }
+
+    free(r);
+}
+
+static int init_delay(struct DelayLine *d, int length) {
+    d->length = length * audio_spec.freq / 44100;
+
+    if (d->length < 1) {
+        d->length = 1;
+    }
+
+    d->index = 0;
+    d->filter = 0;
+    d->buffer = calloc(d->length, sizeof(float));
+
+    return d->buffer != NULL;
+}
+
+static struct Reverb *alloc_reverb(void) {
+    struct Reverb *r = calloc(1, sizeof(struct Reverb));
+    int ok = 1;
+
+    if (!r) {
+        return NULL;
+    }
+
+    for (int side = 0; side < 2; side++) {
+        for (int i = 0; i < REVERB_COMBS; i++) {
+            ok &= init_delay(&r->comb[side][i], comb_lengths[i] + side * REVERB_SPREAD);
+        }
+
+        for (int i = 0; i < REVERB_ALLPASSES; i++) {
+            ok &= init_delay(&r->allpass[side][i], allpass_lengths[i] + side * REVERB_SPREAD);
+        }
+    }
+
+    if (!ok) {
+        free_reverb(r);
+        return NULL;
+    }
+
+    return r;
+}
+
+/*
+ * Computes bus_order. A bus can be processed once all the buses that are
+ * mixed or sent into it have been. Buses in a cycle are processed in
+ * numeric order.
+ */
+static void compute_bus_order(void) {
+    int done[MAX_BUSES];
+    int count = 0;
+
+    memset(done, 0, sizeof(done));
+
+    while (count < num_buses) {
+        int progress = 0;
+
+        for (int i = num_buses - 1; i >= 0; i--) {
+
+            if (done[i]) {
+                continue;
+            }
+
+            int ready = 1;
+
+            for (int j = 0; j < num_buses; j++) {
+                if (!done[j] && j != i && (buses[j].parent == i || buses[j].reverb_bus == i)) {
+                    ready = 0;
+                    break;
+                }
+            }
+
+            if (ready) {
+                bus_order[count++] = i;
+                done[i] = 1;
+                progress = 1;
+            }
+        }
+
+        if (!progress) {
+            for (int i = 0; i < num_buses; i++) {
+                if (!done[i]) {
+                    bus_order[count++] = i;
+                    done[i] = 1;
+                }
+            }
+        }
+    }
+}
+
+/* Returns a pointer to the buffer for `bus`. */
+static inline float *bus_buffer(int bus) {
+    return bus_buffers + bus * bus_buffer_length * 2;
+}
+
+/* Makes sure the bus buffers can hold `length` samples. Returns 0 if they
+ * can't. This allocates memory, so it must be called with the audio lock
+ * held, and never from the audio callback. */
+static int ensure_bus_buffers(int length) {
+    if (length <= bus_buffer_length) {
+        return 1;
+    }
+
+    float *new_buffers = realloc(bus_buffers, MAX_BUSES * length * 2 * sizeof(float));
+
+    if (!new_buffers) {
+        return 0;
+    }
+
+    bus_buffers = new_buffers;
+    bus_buffer_length = length;
+
+    return 1;
+}
+
+/* The effects are written as simple loops over contiguous float arrays,
+ * so the compiler can vectorize them. */
+
+static void apply_gain(float * restrict buf, int length, float start, float end) {
+    float step = (end - start) / length;
+
+    if (start == end) {
+        if (start == 1.0) {
+            return;
+        }
+
+        for (int i = 0; i < length * 2; i++) {
+            buf[i] *= start;
+        }
+
+        return;
+    }
+
+    for (int i = 0; i < length; i++) {
+        float g = start + step * i;
+        buf[i * 2] *= g;
+        buf[i * 2 + 1] *= g;
+    }
+}
+
+static void apply_lowpass(struct Bus *b, float * restrict buf, int length) {
+    float a = b->lowpass;
+
+    for (int side = 0; side < 2; side++) {
+        float s0 = b->lowpass_state[side][0];
+        float s1 = b->lowpass_state[side][1];
+
+        for (int i = side; i < length * 2; i += 2) {
+            s0 += a * (buf[i] - s0);
+            s1 += a * (s0 - s1);
+            buf[i] = s1;
+        }
+
+        b->lowpass_state[side][0] = s0;
+        b->lowpass_state[side][1] = s1;
+    }
+}
+
+static void apply_reverb(struct Reverb *r, float * restrict buf, int length) {
+
+    for (int side = 0; side < 2; side++) {
+        for (int i = side; i < length * 2; i += 2) {
+
+            // The input is scaled down, as the combs sum together.
+            float in = buf[i] * .015;
+            float out = 0;
+
+            for (int j = 0; j < REVERB_COMBS; j++) {
+                struct DelayLine *d = &r->comb[side][j];
+                float delayed = d->buffer[d->index];
+
+                d->filter = delayed + r->damping * (d->filter - delayed);
+                d->buffer[d->index] = in + d->filter * r->feedback;
+
+                if (++d->index >= d->length) {
+                    d->index = 0;
+                }
+
+                out += delayed;
+            }
+
+            for (int j = 0; j < REVERB_ALLPASSES; j++) {
+                struct DelayLine *d = &r->allpass[side][j];
+                float delayed = d->buffer[d->index];
+
+                d->buffer[d->index] = out + delayed * .5;
+                out = delayed - out;
+
+                if (++d->index >= d->length) {
+                    d->index = 0;
+                }
+            }
+
+            buf[i] = out * r->wet;
+        }
+    }
+}
+
+static float block_peak(const float * restrict buf, int length) {
+    float rv = 0;
+
+    for (int i = 0; i < length * 2; i++) {
+        float v = fabsf(buf[i]);
+        rv = v > rv ? v : rv;
+    }
+
+    return rv;
+}
+
+/* Computes the ducking gain for the block. */
+static float duck_gain(struct Bus *b, int length) {
+    float level = buses[b->duck_source].level;
+    float block_time = 1.0 * length / audio_spec.freq;
+    float time = level > b->duck_envelope ? b->duck_attack : b->duck_release;
+    float coef = time > 0 ? expf(-block_time / time) : 0;
+
+    b->duck_envelope = level + coef * (b->duck_envelope - level);
+
+    if (b->duck_envelope <= b->duck_threshold || b->duck_threshold <= 0) {
+        return 1.0;
+    }
+
+    // The gain reduction, in the log domain, is the amount over the
+    // threshold times (1 - 1 / ratio).
+    return powf(b->duck_threshold / b->duck_envelope, 1.0 - 1.0 / b->duck_ratio);
+}
+
+/* Applies the effects of `bus` to its buffer, and mixes it into its parent
+ * and reverb buses. */
+static void process_bus(int bus, int length) {
+    struct Bus *b = &buses[bus];
+    float *buf = bus_buffer(bus);
+
+    if (b->lowpass > 0) {
+        apply_lowpass(b, buf, length);
+    }
+
+    if (b->reverb) {
+        apply_reverb(b->reverb, buf, length);
+    }
+
+    float start = get_interpolate(&b->volume) * b->duck_gain;
+
+    b->volume.done = min(b->volume.done + length, b->volume.duration);
+
+    if (b->duck_source >= 0) {
+        b->duck_gain = duck_gain(b, length);
+    } else {
+        b->duck_gain = 1.0;
+    }
+
+    float end = get_interpolate(&b->volume) * b->duck_gain;
+
+    apply_gain(buf, length, start, end);
+
+    b->level = block_peak(buf, length);
+
+    if (b->reverb_bus >= 0 && b->reverb_send > 0) {
+        float * restrict rbuf = bus_buffer(b->reverb_bus);
+
+        for (int i = 0; i < length * 2; i++) {
+            rbuf[i] += buf[i] * b->reverb_send;
+        }
+    }
+
+    if (b->parent >= 0) {
+        float * restrict pbuf = bus_buffer(b->parent);
+
+        for (int i = 0; i < length * 2; i++) {
+            pbuf[i] += buf[i];
+        }
+    }
+}
+
 /** If not NULL, this can be replaced with a function that will be called
     to generate audio. The functtio is called with a consistion of 2*length
     shorts, and should fill the buffer with audio data. */
@@ -394,10 +829,19 @@ static void callback(void *userdata, Uint8 *stream, int length) {
     // Convert the length to samples.
     length /= 4;
 
-    float mix_buffer[length * 2];
     short stream_buffer[length * 2];
 
-    memset(mix_buffer, 0, length * 2 * sizeof(float));
+    // The buffers are allocated before the callback runs, as allocating
+    // memory here could block the audio thread.
+    if (length > bus_buffer_length) {
+        memset(stream, 0, length * 4);
+        return;
+    }
+
+    memset(bus_buffers, 0, num_buses * bus_buffer_length * 2 * sizeof(float));
+
+    // The master bus.
+    float *mix_buffer = bus_buffer(0);
 
     if (RPS_generate_audio_c_function) {
         RPS_generate_audio_c_function(mix_buffer, length);
@@ -415,6 +859,8 @@ static void callback(void *userdata, Uint8 *stream, int length) {
             continue;
         }
 
+        float *channel_buffer = bus_buffer(c->bus);
+
         while (mixed < length && c->playing) {
 
             // How much do we have left to mix on this channel?
@@ -464,6 +910,10 @@ static void callback(void *userdata, Uint8 *stream, int length) {
 
                 UNLOCK_NAME()
 
+                // The stream has ended, and there's now room in the queue
+                // for another.
+                post_periodic_event(RPS_EVENT_ENDED);
+
                 start_stream(c, !old_tight);
 
                 continue;
@@ -472,7 +922,7 @@ static void callback(void *userdata, Uint8 *stream, int length) {
             // We have some data in the buffer, so mix it.
             for (int i = 0; (i < read_length) && c->stop_samples; i++) {
 
-                mix_sample(c, stream_buffer[i * 2], stream_buffer[i * 2 + 1], &mix_buffer[mixed * 2], &mix_buffer[mixed * 2 + 1]);
+                mix_sample(c, stream_buffer[i * 2], stream_buffer[i * 2 + 1], &channel_buffer[mixed * 2], &channel_buffer[mixed * 2 + 1]);
 
                 if (c->stop_samples > 0) {
                     c->stop_samples--;
@@ -487,6 +937,12 @@ static void callback(void *userdata, Uint8 *stream, int length) {
         c->last_playing = 1;
     }
 
+    // Process the buses, mixing each into its parent, until everything is
+    // in the master bus.
+    for (int i = 0; i < num_buses; i++) {
+        process_bus(bus_order[i], length);
+    }
+
     // Actually output the sound.
     for (int i = 0; i < length; i++) {
         int left = mix_buffer[i * 2] * MAX_SHORT;
@@ -509,6 +965,9 @@ static void callback(void *userdata, Uint8 *stream, int length) {
         ((short *) stream)[i * 2 + 1] = right;
     }
 
+    if (capture) {
+        encode_audio(capture, (short *) stream, length);
+    }
 
 }
 
@@ -1170,6 +1629,8 @@ void RPS_init(int freq, int stereo, int samples, int status, int equal_mono, int
     }
 
     name_mutex = SDL_CreateMutex();
+    event_mutex = SDL_CreateMutex();
+    event_cond = SDL_CreateCond();
 
 #ifndef __EMSCRIPTEN__
 #if PY_VERSION_HEX < 0x03070000
@@ -1184,6 +1645,17 @@ void RPS_init(int freq, int stereo, int samples, int status, int equal_mono, int
         return;
     }
 
+    // Free the effects of the buses used before the audio system was last
+    // shut down.
+    for (int i = 0; i < MAX_BUSES; i++) {
+        free_reverb(buses[i].reverb);
+        buses[i].reverb = NULL;
+    }
+
+    init_bus(&buses[0], -1);
+    num_buses = 1;
+    compute_bus_order();
+
     audio_spec.freq = freq;
     audio_spec.format = AUDIO_S16SYS;
     audio_spec.channels = stereo;
@@ -1196,6 +1668,17 @@ void RPS_init(int freq, int stereo, int samples, int status, int equal_mono, int
         return;
     }
 
+    LOCK_AUDIO();
+    int buffers_ok = ensure_bus_buffers(audio_spec.samples);
+    UNLOCK_AUDIO();
+
+    if (!buffers_ok) {
+        SDL_CloseAudio();
+        error(RPS_ERROR);
+        error_msg = "Could not allocate the bus buffers.";
+        return;
+    }
+
     media_init(audio_spec.freq, status, equal_mono);
 
     SDL_PauseAudio(0);
@@ -1248,6 +1731,268 @@ void RPS_periodic() {
 
 }
 
+/*
+ * Checks that the given bus is in range. Returns 0 if it is, sets an
+ * error and returns -1 if it is not.
+ */
+static int check_bus(int bus) {
+
+    if (bus < 0 || bus >= MAX_BUSES) {
+        error(RPS_ERROR);
+        error_msg = "Bus number out of range.";
+        return -1;
+    }
+
+    if (bus >= num_buses) {
+        LOCK_AUDIO();
+
+        for (int i = num_buses; i <= bus; i++) {
+            init_bus(&buses[i], 0);
+        }
+
+        num_buses = bus + 1;
+        compute_bus_order();
+
+        UNLOCK_AUDIO();
+    }
+
+    return 0;
+}
+
+/*
+ * Sets the bus that `channel` is mixed into.
+ */
+void RPS_set_channel_bus(int channel, int bus) {
+
+    if (check_channel(channel) || check_bus(bus)) {
+        return;
+    }
+
+    LOCK_AUDIO();
+    channels[channel].bus = bus;
+    UNLOCK_AUDIO();
+
+    error(SUCCESS);
+}
+
+/*
+ * Sets the bus that `bus` is mixed into. The master bus, bus 0, can't be
+ * given a parent.
+ */
+void RPS_set_bus_parent(int bus, int parent) {
+
+    if (check_bus(bus) || check_bus(parent)) {
+        return;
+    }
+
+    if (bus == 0) {
+        error(RPS_ERROR);
+        error_msg = "The master bus can't have a parent.";
+        return;
+    }
+
+    // Walk up from the new parent, to be sure bus isn't one of its
+    // ancestors. Every chain ends at the master bus, as this check has
+    // been made each time a parent was set.
+    for (int p = parent; p >= 0; p = buses[p].parent) {
+        if (p == bus) {
+            error(RPS_ERROR);
+            error_msg = "A bus can't be mixed into itself.";
+            return;
+        }
+    }
+
+    LOCK_AUDIO();
+    buses[bus].parent = parent;
+    compute_bus_order();
+    UNLOCK_AUDIO();
+
+    error(SUCCESS);
+}
+
+/*
+ * Changes the volume of `bus` to `volume` over `delay` seconds.
+ */
+void RPS_set_bus_volume(int bus, float volume, float delay) {
+    struct Bus *b;
+
+    if (check_bus(bus)) {
+        return;
+    }
+
+    b = &buses[bus];
+
+    LOCK_AUDIO();
+
+    b->volume.start = get_interpolate(&b->volume);
+    b->volume.end = volume;
+    b->volume.done = 0;
+    b->volume.duration = ms_to_samples(delay * 1000);
+
+    UNLOCK_AUDIO();
+
+    error(SUCCESS);
+}
+
+/*
+ * Sets the cutoff frequency of the low-pass filter on `bus`, in Hz. A
+ * cutoff of 0 disables the filter.
+ */
+void RPS_set_bus_lowpass(int bus, float cutoff) {
+    struct Bus *b;
+
+    if (check_bus(bus)) {
+        return;
+    }
+
+    b = &buses[bus];
+
+    LOCK_AUDIO();
+
+    if (cutoff <= 0 || cutoff >= audio_spec.freq / 2) {
+        b->lowpass = 0;
+    } else {
+        b->lowpass = 1.0 - expf(-2.0 * PI * cutoff / audio_spec.freq);
+    }
+
+    UNLOCK_AUDIO();
+
+    error(SUCCESS);
+}
+
+/*
+ * Causes `bus` to be ducked when the level of `source` goes above
+ * `threshold`, compressing by `ratio`. `attack` and `release` are the
+ * time constants, in seconds. A `source` of -1 disables ducking.
+ */
+void RPS_set_bus_duck(int bus, int source, float threshold, float ratio, float attack, float release) {
+    struct Bus *b;
+
+    if (check_bus(bus) || (source >= 0 && check_bus(source))) {
+        return;
+    }
+
+    b = &buses[bus];
+
+    LOCK_AUDIO();
+
+    b->duck_source = source;
+    b->duck_threshold = threshold;
+    b->duck_ratio = ratio >= 1.0 ? ratio : 1.0;
+    b->duck_attack = attack;
+    b->duck_release = release;
+    b->duck_envelope = 0;
+
+    UNLOCK_AUDIO();
+
+    error(SUCCESS);
+}
+
+/*
+ * Sends `amount` of the output of `bus` to `reverb_bus`. A `reverb_bus`
+ * of -1 disables the send.
+ */
+void RPS_set_bus_reverb_send(int bus, int reverb_bus, float amount) {
+
+    if (check_bus(bus) || (reverb_bus >= 0 && check_bus(reverb_bus))) {
+        return;
+    }
+
+    LOCK_AUDIO();
+    buses[bus].reverb_bus = reverb_bus;
+    buses[bus].reverb_send = amount;
+    compute_bus_order();
+    UNLOCK_AUDIO();
+
+    error(SUCCESS);
+}
+
+/*
+ * Makes `bus` a reverb bus, replacing its input with the reverberated
+ * signal. `room` and `damping` range from 0 to 1. A `wet` of 0 disables
+ * the reverb.
+ */
+void RPS_set_bus_reverb(int bus, float room, float damping, float wet) {
+    struct Reverb *r = NULL;
+    struct Reverb *old;
+
+    if (check_bus(bus)) {
+        return;
+    }
+
+    if (wet > 0) {
+        old = buses[bus].reverb;
+
+        if (old) {
+            r = old;
+        } else {
+            r = alloc_reverb();
+        }
+
+        if (!r) {
+            error(RPS_ERROR);
+            error_msg = "Could not allocate reverb.";
+            return;
+        }
+    }
+
+    LOCK_AUDIO();
+
+    old = buses[bus].reverb;
+    buses[bus].reverb = r;
+
+    if (r) {
+        r->feedback = .7 + .28 * room;
+        r->damping = .4 * damping;
+        r->wet = wet;
+    }
+
+    UNLOCK_AUDIO();
+
+    if (old && old != r) {
+        free_reverb(old);
+    }
+
+    error(SUCCESS);
+}
+
+/*
+ * Waits up to `timeout` ms for an event to be posted by the audio callback
+ * or RPS_post_wakeup, releasing the GIL while waiting. Returns a bitmask
+ * of the RPS_EVENT_* flags that were posted since the last call, or 0 if
+ * the wait timed out.
+ */
+int RPS_wait_event(int timeout) {
+    int rv;
+
+    Py_BEGIN_ALLOW_THREADS
+
+    SDL_LockMutex(event_mutex);
+
+    if (!pending_events) {
+        SDL_CondWaitTimeout(event_cond, event_mutex, timeout);
+    }
+
+    rv = pending_events;
+    pending_events = 0;
+
+    SDL_UnlockMutex(event_mutex);
+
+    Py_END_ALLOW_THREADS
+
+    error(SUCCESS);
+    return rv;
+}
+
+/*
+ * Wakes up the thread waiting in RPS_wait_event, so that the periodic
+ * pass runs.
+ */
+void RPS_post_wakeup(void) {
+    post_periodic_event(RPS_EVENT_WAKEUP);
+    error(SUCCESS);
+}
+
 void RPS_advance_time(void) {
 	media_advance_time();
 }
@@ -1262,6 +2007,135 @@ void RPS_sample_surfaces(PyObject *rgb, PyObject *rgba) {
 
 }
 
+/*
+ * Starts capturing the game to `filename`. Frames are given to
+ * RPS_capture_video, while audio is taken from the mixer. If `fixed` is
+ * true, the audio device is paused and audio is only mixed when
+ * RPS_capture_audio is called, so the capture can run at a fixed
+ * timestep rather than in real time.
+ */
+void RPS_capture_start(const char *filename, int width, int height, int fps, int fixed, int max_queued_frames) {
+
+    EncodeState *es;
+
+    if (capture) {
+        error(RPS_ERROR);
+        error_msg = "Already capturing.";
+        return;
+    }
+
+    es = encode_open(filename, width, height, fps, initialized ? audio_spec.freq : 0, max_queued_frames);
+
+    if (!es) {
+        error(RPS_ERROR);
+        error_msg = "Could not open the capture file for encoding.";
+        return;
+    }
+
+    LOCK_AUDIO();
+    capture = es;
+    capture_fixed = fixed;
+    UNLOCK_AUDIO();
+
+    if (fixed && initialized) {
+        SDL_PauseAudio(1);
+    }
+
+    error(SUCCESS);
+}
+
+/*
+ * Queues the pixels of `surf` as frame number `frame` of the capture.
+ * Returns 1 if the frame was queued, or 0 if it was dropped.
+ */
+int RPS_capture_video(PyObject *surf, long long frame) {
+    SDL_Surface *s;
+    int rv;
+
+    if (!capture) {
+        return 0;
+    }
+
+    import_pygame_sdl2();
+
+    s = PySurface_AsSurface(surf);
+
+    Py_BEGIN_ALLOW_THREADS
+    rv = encode_video(capture, (Uint8 *) s->pixels, s->w, s->h, s->pitch, frame, capture_fixed);
+    Py_END_ALLOW_THREADS
+
+    error(SUCCESS);
+    return rv;
+}
+
+/*
+ * In fixed-timestep mode, mixes `samples` samples of audio and sends them
+ * to the capture.
+ */
+void RPS_capture_audio(int samples) {
+
+    if (!capture || !capture_fixed || !initialized) {
+        return;
+    }
+
+    Uint8 *stream = malloc(samples * 4);
+
+    if (!stream) {
+        return;
+    }
+
+    LOCK_AUDIO();
+
+    if (ensure_bus_buffers(samples)) {
+        callback(NULL, stream, samples * 4);
+    } else {
+        memset(stream, 0, samples * 4);
+    }
+
+    UNLOCK_AUDIO();
+
+    free(stream);
+
+    error(SUCCESS);
+}
+
+/*
+ * Stops the capture, waiting for the encoder to finish. Returns the number
+ * of frames that were dropped, or -1 if the encoder failed.
+ */
+int RPS_capture_stop(void) {
+    EncodeState *es;
+    int rv;
+
+    if (!capture) {
+        return 0;
+    }
+
+    LOCK_AUDIO();
+    es = capture;
+    capture = NULL;
+    UNLOCK_AUDIO();
+
+    if (capture_fixed && initialized) {
+        SDL_PauseAudio(0);
+    }
+
+    capture_fixed = 0;
+
+    rv = encode_dropped_frames(es);
+
+    Py_BEGIN_ALLOW_THREADS
+
+    if (encode_close(es)) {
+        rv = -1;
+    }
+
+    Py_END_ALLOW_THREADS
+
+    error(SUCCESS);
+    return rv;
+}
+
 /*
  * Returns the error message string if an error has occured, or
  * NULL if no error has happened.
@@ -53,6 +53,26 @@ void RPS_set_video(int channel, int video);
 void RPS_init(int freq, int stereo, int samples, int status, int equal_mono, int linear_fades);
 void RPS_quit(void);
 
+void RPS_capture_start(const char *filename, int width, int height, int fps, int fixed, int max_queued_frames);
+int RPS_capture_video(PyObject *surf, long long frame);
+void RPS_capture_audio(int samples);
+int RPS_capture_stop(void);
+
+void RPS_set_channel_bus(int channel, int bus);
+void RPS_set_bus_parent(int bus, int parent);
+void RPS_set_bus_volume(int bus, float volume, float delay);
+void RPS_set_bus_lowpass(int bus, float cutoff);
+void RPS_set_bus_duck(int bus, int source, float threshold, float ratio, float attack, float release);
+void RPS_set_bus_reverb_send(int bus, int reverb_bus, float amount);
+void RPS_set_bus_reverb(int bus, float room, float damping, float wet);
+
+/* Flags returned by RPS_wait_event. */
+#define RPS_EVENT_WAKEUP 1
+#define RPS_EVENT_ENDED 2
+
+int RPS_wait_event(int timeout);
+void RPS_post_wakeup(void);
+
 void RPS_advance_time(void);
 void RPS_periodic(void);
 
@@ -101,6 +101,15 @@ library("z")
 has_libglew = library("GLEW", optional=True)
 has_libglew32 = library("glew32", optional=True)
 
+# On android, ios, and emscripten, include and library always succeed, so
+# the optional image decoders have to be enabled by the build environment.
+if android or ios or emscripten:
+    has_turbojpeg = "RENPY_TURBOJPEG" in os.environ
+    has_webp = "RENPY_WEBP" in os.environ
+else:
+    has_turbojpeg = include("turbojpeg.h", optional=True) and library("turbojpeg", optional=True)
+    has_webp = include("webp/decode.h", optional=True) and library("webp", optional=True)
+
 if android:
     sdl = [ 'SDL2', 'GLESv2', 'log' ]
     png = 'png16'
@@ -140,7 +149,7 @@ if has_swscale:
 
 cython(
     "renpy.audio.renpysound",
-    [ "renpysound_core.c", "ffmedia.c" ],
+    [ "renpysound_core.c", "ffmedia.c", "ffencode.c" ],
     libs=sdl + sound,
     define_macros=macros)
 
@@ -167,6 +176,20 @@ cython("renpy.display.matrix")
 cython("renpy.display.render", libs=[ 'z', 'm' ])
 cython("renpy.display.accelerator", libs=sdl + [ 'z', 'm' ])
 cython("renpy.display.quaternion", libs=[ 'm' ])
+cython("renpy.display.layoutsupport", libs=[ 'm' ])
+
+decode_libs = [ png, 'z' ]
+decode_macros = [ ]
+
+if has_turbojpeg:
+    decode_libs.append("turbojpeg")
+    decode_macros.append(("HAVE_TURBOJPEG", 1))
+
+if has_webp:
+    decode_libs.append("webp")
+    decode_macros.append(("HAVE_WEBP", 1))
+
+cython("renpy.display.imagedecode", [ "imagedecode.c" ], libs=sdl + decode_libs, define_macros=decode_macros)
 
 cython("renpy.uguu.gl", libs=sdl)
 cython("renpy.uguu.uguu", libs=sdl)
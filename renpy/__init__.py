@@ -206,6 +206,7 @@ backup_blacklist = {
     "renpy.compat.dictviews",
     "renpy.object",
     "renpy.log",
+    "renpy.startupprofile",
     "renpy.bootstrap",
     "renpy.debug",
     "renpy.display",
@@ -390,6 +391,7 @@ def import_all():
 
     import renpy.config
     import renpy.log
+    import renpy.startupprofile
 
     import renpy.arguments # @UnresolvedImport
 
@@ -407,6 +409,7 @@ def import_all():
 
     # Adds in the Ren'Py loader.
     import renpy.loader
+    import renpy.zygote
 
     if not PY2:
         import renpy.py3analysis
@@ -414,6 +417,7 @@ def import_all():
         import renpy.py2analysis
 
     import renpy.pyanalysis
+    import renpy.lookahead
 
     import renpy.ast
     import renpy.atl
@@ -461,6 +465,7 @@ def import_all():
 
     import renpy.display.presplash
     import renpy.display.pgrender
+    import renpy.display.imagedecode
     import renpy.display.scale
     import renpy.display.module
     import renpy.display.render
@@ -482,6 +487,7 @@ def import_all():
     import renpy.gl
     import renpy.gl2
 
+    import renpy.display.layoutsupport
     import renpy.display.layout
     import renpy.display.viewport
     import renpy.display.transform
@@ -505,6 +511,7 @@ def import_all():
     import renpy.display.predict
     import renpy.display.emulator
     import renpy.display.tts
+    import renpy.display.capture
     import renpy.display.gesture
     import renpy.display.model
     import renpy.display.quaternion
@@ -711,6 +718,7 @@ if 1 == 0:
     from . import lexersupport
     from . import lint
     from . import loader
+    from . import lookahead
     from . import loadsave
     from . import log
     from . import main
@@ -734,6 +742,7 @@ if 1 == 0:
     from . import script
     from . import scriptedit
     from . import sl2
+    from . import startupprofile
     from . import statements
     from . import style
     from . import styledata
@@ -748,3 +757,4 @@ if 1 == 0:
     from . import versions
     from . import warp
     from . import webloader
+    from . import zygote
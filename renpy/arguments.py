@@ -110,6 +110,18 @@ class ArgumentParser(argparse.ArgumentParser):
             '--trace', dest='trace', action='store', default=0, type=int, metavar="LEVEL",
             help="The level of trace Ren'Py will log to trace.txt. (1=per-call, 2=per-line)")
 
+        self.add_argument(
+            '--startup-profile', dest='startup_profile', action='store', default=None, metavar="FILE",
+            help="Records a timeline of startup until the first frame is drawn, and writes it to FILE as a Chrome trace.")
+
+        self.add_argument(
+            '--startup-profile-quit', dest='startup_profile_quit', action='store_true', default=False,
+            help="With --startup-profile, quits once the first frame has been drawn.")
+
+        self.add_argument(
+            '--zygote', dest='zygote', action='store_true', default=False,
+            help="On Linux, loads the game and waits for later launches of it, which are forked from this process.")
+
         self.add_argument(
             "--version", action='version', version=renpy.version,
             help="Displays the version of Ren'Py in use.")
@@ -69,7 +69,7 @@ def load(fn):
     """
 
     try:
-        rv = renpy.loader.load(fn, directory="audio")
+        rv = renpy.loader.load(fn, directory="audio", priority=renpy.loader.IO_AUDIO)
     except renpy.webloader.DownloadNeeded as exception:
         if exception.rtype == 'music':
             renpy.webloader.enqueue(exception.relpath, 'music', None)
@@ -228,6 +228,9 @@ class Channel(object):
         # The actual volume we imparted onto this channel.
         self.actual_volume = 1.0
 
+        # The bus this channel is mixed into.
+        self.actual_bus = 0
+
         # The QueueEntries queued for playback on this channel.
         self.queue = [ ]
 
@@ -444,6 +447,13 @@ class Channel(object):
             renpysound.set_volume(self.number, vol)
             self.actual_volume = vol
 
+        # Route the channel into its mixer's bus.
+        bus = get_bus(self.mixer)
+
+        if bus != self.actual_bus:
+            renpysound.set_channel_bus(self.number, bus)
+            self.actual_bus = bus
+
         # This should be set from something that checks to see if our
         # mixer is muted.
         force_stop = self.context.force_stop or (renpy.game.preferences.mute.get(self.mixer, False) and self.stop_on_mute)
@@ -699,7 +709,7 @@ class Channel(object):
                 self.loop = [ ]
 
         with periodic_condition:
-            periodic_condition.notify()
+            wake_periodic_thread()
 
     def get_playing(self):
 
@@ -934,6 +944,73 @@ def set_force_stop(name, value):
     get_channel(name).context.force_stop = value
 
 
+# A map from the name of a mixer to the number of the submix bus it's mixed
+# into. The master bus, which every other bus is eventually mixed into, is
+# bus 0.
+bus_numbers = { "master" : 0 }
+
+# The number of buses renpysound supports. This must match MAX_BUSES in
+# renpysound_core.c.
+MAX_BUSES = 32
+
+# A map from bus number to a dict giving the effects set on that bus, so
+# the effects can be reapplied if the audio system is reinitialized. The
+# dict maps the name of a renpysound function to its arguments, after the
+# bus.
+bus_effects = { }
+
+
+def get_bus(mixer):
+    """
+    Returns the number of the submix bus for `mixer`, allocating one if
+    needed.
+    """
+
+    if mixer is None:
+        return 0
+
+    rv = bus_numbers.get(mixer, None)
+
+    if rv is None:
+
+        if len(bus_numbers) >= MAX_BUSES:
+            raise Exception("Mixer {!r} can't be given a submix bus, as at most {} mixers other than master can have one.".format(mixer, MAX_BUSES - 1))
+
+        rv = bus_numbers[mixer] = len(bus_numbers)
+
+    return rv
+
+
+def set_bus_effect(mixer, function, *args):
+    """
+    Calls the renpysound function named `function` with the bus for
+    `mixer` and `args`, and records it so it can be reapplied.
+    """
+
+    bus = get_bus(mixer)
+
+    with lock:
+        bus_effects.setdefault(bus, { })[function] = args
+
+        if pcm_ok:
+            getattr(renpysound, function)(bus, *args)
+
+
+def apply_bus_effects():
+    """
+    Reapplies the effects in bus_effects, after renpysound has been
+    initialized.
+    """
+
+    for bus, effects in bus_effects.items():
+        for function, args in effects.items():
+            try:
+                getattr(renpysound, function)(bus, *args)
+            except Exception:
+                if renpy.config.debug_sound:
+                    raise
+
+
 # The thread that call periodic.
 periodic_thread = None
 
@@ -998,6 +1075,12 @@ def init():
             except Exception:
                 pcm_ok = False
 
+    if pcm_ok:
+        for c in all_channels:
+            c.actual_bus = 0
+
+        apply_bus_effects()
+
     # Find all of the mixers in the game.
     mixers = [ ]
 
@@ -1045,7 +1128,7 @@ def quit(): # @ReservedAssignment
         with periodic_condition:
 
             periodic_thread_quit = True
-            periodic_condition.notify()
+            wake_periodic_thread()
 
         periodic_thread.join()
 
@@ -1158,6 +1241,55 @@ run_periodic = False
 # The condition the perodic thread runs on.
 periodic_condition = threading.Condition()
 
+# How long the periodic thread waits for an event before running anyway,
+# in seconds. This is a safety net - normally the thread is woken up by
+# renpysound when a stream ends, or by the main thread when something
+# changes.
+periodic_thread_timeout = 1.0
+
+# The last value of periodic_state, when the periodic thread was woken up.
+last_periodic_state = None
+
+
+def wake_periodic_thread():
+    """
+    Wakes up the periodic thread. This must be called with periodic_condition
+    held.
+    """
+
+    if pcm_ok:
+        renpysound.post_wakeup()
+
+    periodic_condition.notify()
+
+
+def periodic_state():
+    """
+    Returns an object that changes when the periodic pass might have
+    something to do that renpysound won't tell the periodic thread about.
+    """
+
+    rv = [
+        global_pause,
+        renpy.game.preferences.self_voicing,
+        renpy.game.preferences.emphasize_audio,
+        tuple(renpy.game.preferences.volumes.items()),
+        tuple(renpy.game.preferences.mute.items()),
+        ]
+
+    for c in all_channels:
+        rv.append((
+            len(c.queue),
+            c.mixer,
+            c.playing,
+            c.wait_stop,
+            c.synchro_start,
+            c.chan_volume,
+            c.context.force_stop,
+            ))
+
+    return rv
+
 
 def periodic_thread_main():
 
@@ -1165,16 +1297,21 @@ def periodic_thread_main():
     global run_periodic
 
     while True:
+
+        # Wait for renpysound to report that a stream ended, or for the
+        # main thread to wake us. If the wait times out, the periodic pass
+        # runs anyway, in case something was missed.
+        if pcm_ok:
+            renpysound.wait_event(periodic_thread_timeout)
+
         with periodic_condition:
-            if not run_periodic:
-                periodic_condition.wait(.05)
+
+            if not (pcm_ok or run_periodic or periodic_thread_quit):
+                periodic_condition.wait(periodic_thread_timeout)
 
             if periodic_thread_quit:
                 return
 
-            if not run_periodic:
-                continue
-
             run_periodic = False
 
         with lock:
@@ -1188,6 +1325,7 @@ def periodic_thread_main():
 def periodic():
     global periodic_exc
     global run_periodic
+    global last_periodic_state
 
     if not renpy.config.audio_periodic_thread:
         periodic_pass()
@@ -1204,8 +1342,17 @@ def periodic():
 
             raise_(exc[0], exc[1], exc[2])
 
+        # Only wake the periodic thread if something changed, as it's
+        # woken by renpysound when streams end.
+        state = periodic_state()
+
+        if state == last_periodic_state:
+            return
+
+        last_periodic_state = state
+
         run_periodic = True
-        periodic_condition.notify()
+        wake_periodic_thread()
 
 
 def interact():
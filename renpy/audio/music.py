@@ -602,11 +602,108 @@ def set_mixer(channel, mixer, default=False):
         if not default or c.mixer is None:
             c.mixer = mixer
 
+            # The channel is routed into its mixer's bus by the periodic
+            # pass.
+            with renpy.audio.audio.periodic_condition:
+                renpy.audio.audio.wake_periodic_thread()
+
     except Exception:
         if renpy.config.debug_sound:
             raise
 
 
+def set_mixer_parent(mixer, parent):
+    """
+    :doc: audio_buses
+
+    Each mixer has a submix bus that the channels using it are mixed into.
+    This makes the bus for `mixer` mix into the bus for `parent`, rather
+    than directly into the master bus, so effects applied to `parent`
+    apply to `mixer` as well. `parent` may be "master".
+    """
+
+    renpy.audio.audio.set_bus_effect(mixer, "set_bus_parent", renpy.audio.audio.get_bus(parent))
+
+
+def set_mixer_lowpass(mixer, cutoff):
+    """
+    :doc: audio_buses
+
+    Applies a low-pass filter to the bus for `mixer`.
+
+    `cutoff`
+        The cutoff frequency of the filter, in Hz. If None, the filter
+        is removed.
+    """
+
+    renpy.audio.audio.set_bus_effect(mixer, "set_bus_lowpass", cutoff)
+
+
+def set_mixer_duck(mixer, source, threshold=0.1, ratio=4.0, attack=0.01, release=0.3):
+    """
+    :doc: audio_buses
+
+    Causes the bus for `mixer` to be ducked - made quieter - when the bus
+    for `source` is playing loudly. For example, this can be used to lower
+    the music while voice is playing.
+
+    `source`
+        The mixer that causes ducking. If None, ducking is disabled.
+
+    `threshold`
+        The peak level of `source`, from 0.0 to 1.0, above which ducking
+        begins.
+
+    `ratio`
+        How much `mixer` is compressed, relative to how far `source` goes
+        above `threshold`.
+
+    `attack`, `release`
+        The time, in seconds, it takes the ducking to begin and end.
+    """
+
+    if source is not None:
+        source = renpy.audio.audio.get_bus(source)
+
+    renpy.audio.audio.set_bus_effect(mixer, "set_bus_duck", source, threshold, ratio, attack, release)
+
+
+def set_mixer_reverb(mixer, room=0.5, damping=0.5, wet=1.0):
+    """
+    :doc: audio_buses
+
+    Turns the bus for `mixer` into a reverb bus. Audio sent to it with
+    :func:`renpy.music.set_mixer_reverb_send`, or played on channels using
+    `mixer`, is replaced with its reverberation.
+
+    `room`
+        The size of the room, from 0.0 to 1.0.
+
+    `damping`
+        How much high frequencies are damped, from 0.0 to 1.0.
+
+    `wet`
+        The volume of the reverberation. If 0.0, the reverb is removed.
+    """
+
+    renpy.audio.audio.set_bus_effect(mixer, "set_bus_reverb", room, damping, wet)
+
+
+def set_mixer_reverb_send(mixer, reverb_mixer, amount):
+    """
+    :doc: audio_buses
+
+    Sends `amount` of the audio of the bus for `mixer` to the bus for
+    `reverb_mixer`, which should have had :func:`renpy.music.set_mixer_reverb`
+    called on it. If `reverb_mixer` is None, the send is removed.
+    """
+
+    if reverb_mixer is not None:
+        reverb_mixer = renpy.audio.audio.get_bus(reverb_mixer)
+
+    renpy.audio.audio.set_bus_effect(mixer, "set_bus_reverb_send", reverb_mixer, amount)
+
+
 def get_all_mixers():
     """
     This gets all mixers in use.
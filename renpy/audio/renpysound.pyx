@@ -74,6 +74,22 @@ cdef extern from "renpysound_core.h":
     void RPS_set_pan(int channel, float pan, float delay)
     void RPS_set_secondary_volume(int channel, float vol2, float delay)
 
+    void RPS_capture_start(char *filename, int width, int height, int fps, int fixed, int max_queued_frames)
+    int RPS_capture_video(object surf, long long frame)
+    void RPS_capture_audio(int samples)
+    int RPS_capture_stop()
+
+    void RPS_set_channel_bus(int channel, int bus)
+    void RPS_set_bus_parent(int bus, int parent)
+    void RPS_set_bus_volume(int bus, float volume, float delay)
+    void RPS_set_bus_lowpass(int bus, float cutoff)
+    void RPS_set_bus_duck(int bus, int source, float threshold, float ratio, float attack, float release)
+    void RPS_set_bus_reverb_send(int bus, int reverb_bus, float amount)
+    void RPS_set_bus_reverb(int bus, float room, float damping, float wet)
+
+    int RPS_wait_event(int timeout)
+    void RPS_post_wakeup()
+
     void RPS_advance_time()
     int RPS_video_ready(int channel)
     object RPS_read_video(int channel)
@@ -420,6 +436,94 @@ def periodic():
 
     RPS_periodic()
 
+def set_channel_bus(channel, bus):
+    """
+    Sets the bus `channel` is mixed into. Buses are numbered densely,
+    starting with the master bus, bus 0, which every channel is mixed
+    into by default.
+    """
+
+    RPS_set_channel_bus(channel, bus)
+    check_error()
+
+def set_bus_parent(bus, parent):
+    """
+    Sets the bus that `bus` is mixed into, after its effects are applied.
+    """
+
+    RPS_set_bus_parent(bus, parent)
+    check_error()
+
+def set_bus_volume(bus, volume, delay):
+    """
+    Sets the volume of `bus` to `volume`, a linear value, over `delay`
+    seconds.
+    """
+
+    RPS_set_bus_volume(bus, volume, delay)
+    check_error()
+
+def set_bus_lowpass(bus, cutoff):
+    """
+    Sets the cutoff of the low-pass filter on `bus` to `cutoff` Hz. If
+    `cutoff` is None, the filter is disabled.
+    """
+
+    RPS_set_bus_lowpass(bus, cutoff or 0)
+    check_error()
+
+def set_bus_duck(bus, source, threshold, ratio, attack, release):
+    """
+    Causes `bus` to be ducked when the peak level of the `source` bus
+    goes above `threshold`, compressing it by `ratio`. `attack` and
+    `release` are the time constants of the ducking, in seconds. If
+    `source` is None, ducking is disabled.
+    """
+
+    if source is None:
+        source = -1
+
+    RPS_set_bus_duck(bus, source, threshold, ratio, attack, release)
+    check_error()
+
+def set_bus_reverb_send(bus, reverb_bus, amount):
+    """
+    Sends `amount` of the output of `bus` to `reverb_bus`. If `reverb_bus`
+    is None, the send is disabled.
+    """
+
+    if reverb_bus is None:
+        reverb_bus = -1
+
+    RPS_set_bus_reverb_send(bus, reverb_bus, amount)
+    check_error()
+
+def set_bus_reverb(bus, room, damping, wet):
+    """
+    Applies reverb to `bus`. `room` and `damping` range from 0.0 to 1.0.
+    If `wet` is 0.0, the reverb is disabled.
+    """
+
+    RPS_set_bus_reverb(bus, room, damping, wet)
+    check_error()
+
+def wait_event(timeout):
+    """
+    Waits up to `timeout` seconds for something to happen that requires
+    the periodic pass to run - a stream ending, or post_wakeup being
+    called. Returns True if something happened, or False if the wait
+    timed out.
+    """
+
+    return bool(RPS_wait_event(int(timeout * 1000)))
+
+def post_wakeup():
+    """
+    Causes the current or next call to wait_event to return True.
+    """
+
+    RPS_post_wakeup()
+
 def advance_time():
     """
     Called to advance time at the start of a frame.
@@ -446,6 +550,57 @@ def set_generate_audio_c_function(fn):
 
     RPS_generate_audio_c_function = <void (*)(float *, int)> <uintptr_t> fn
 
+def capture_start(filename, width, height, fps, fixed=False, max_queued_frames=30):
+    """
+    Starts capturing video and the mixed audio to `filename`. The container
+    and codecs are chosen based on the extension of `filename`.
+
+    `width`, `height`
+        The size of the video.
+
+    `fps`
+        The number of frames per second of the video.
+
+    `fixed`
+        If true, the audio device is paused, and audio is only mixed when
+        capture_audio is called.
+
+    `max_queued_frames`
+        The number of frames that can be waiting for the encoder. When
+        this many frames are queued, capture_video drops frames, or waits
+        if `fixed` is true.
+    """
+
+    filename = filename.encode("utf-8")
+
+    RPS_capture_start(filename, width, height, fps, fixed, max_queued_frames)
+    check_error()
+
+def capture_video(surf, frame):
+    """
+    Queues the RGBA surface `surf` to be encoded as frame number `frame`
+    of the capture. Returns True if the frame was queued, or False if it
+    was dropped.
+    """
+
+    return bool(RPS_capture_video(surf, frame))
+
+def capture_audio(samples):
+    """
+    When capturing in fixed mode, mixes `samples` samples of audio
+    into the capture.
+    """
+
+    RPS_capture_audio(samples)
+
+def capture_stop():
+    """
+    Stops capturing, and waits for the encoder to finish writing the file.
+    Returns the number of dropped frames, or -1 if encoding failed.
+    """
+
+    return RPS_capture_stop()
+
 # Store the sample surfaces so they stay alive.
 rgb_surface = None
 rgba_surface = None
@@ -178,6 +178,11 @@ def bootstrap(renpy_base):
     if args.trace:
         enable_trace(args.trace)
 
+    import renpy.startupprofile
+
+    if args.startup_profile:
+        renpy.startupprofile.start(os.path.abspath(args.startup_profile), args.startup_profile_quit)
+
     if args.basedir:
         basedir = os.path.abspath(args.basedir)
         if not isinstance(basedir, str):
@@ -196,6 +201,11 @@ def bootstrap(renpy_base):
 
     gamedir = renpy.__main__.path_to_gamedir(basedir, name)
 
+    # If a zygote is running for this game, let it run the launch.
+    if not args.zygote:
+        import renpy.zygote
+        renpy.zygote.launch(basedir)
+
     sys.path.insert(0, basedir)
 
     if renpy.macintosh:
@@ -228,7 +238,7 @@ You may be using a system install of python. Please run {0}.sh,
         raise
 
     # If we're not given a command, show the presplash.
-    if args.command == "run" and not renpy.mobile:
+    if args.command == "run" and not renpy.mobile and not args.zygote:
         import renpy.display.presplash # @Reimport
         renpy.display.presplash.start(basedir, gamedir)
 
@@ -247,7 +257,9 @@ You may be using a system install of python. Please run {0}.sh,
 
     # Load the rest of Ren'Py.
     import renpy
-    renpy.import_all()
+
+    with renpy.startupprofile.phase("Import Ren'Py"):
+        renpy.import_all()
 
     renpy.loader.init_importer()
 
@@ -312,6 +324,8 @@ You may be using a system install of python. Please run {0}.sh,
 
         renpy.display.im.cache.quit() # type: ignore
 
+        renpy.display.capture.stop() # type: ignore
+
         if renpy.display.draw: # type: ignore
             renpy.display.draw.quit() # type: ignore
 
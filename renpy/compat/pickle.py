@@ -94,6 +94,13 @@ else:
 
     def load(f):
         up = Unpickler(f, fix_imports=True, encoding="utf-8", errors="surrogateescape")
+
+        if renpy.startupprofile.enabled:
+            token = renpy.startupprofile.unpickle_start()
+            rv = up.load()
+            renpy.startupprofile.unpickle_end(token)
+            return rv
+
         return up.load()
 
     def loads(s):
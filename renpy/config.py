@@ -1398,6 +1398,76 @@ ex_rollback_classes = [ ]
 # Should we revert to the old behavior of box_reverse?
 simple_box_reverse = False
 
+# The number of frames gl2 waits before mapping an asynchronous framebuffer
+# readback.
+gl2_readback_frames = 2
+
+# The number of captured frames that can wait for the encoder before frames
+# are dropped.
+capture_max_queued_frames = 30
+
+# The number of statements, in a BFS along all paths, that lookahead
+# analysis looks at to find images, fonts, and audio to load ahead of
+# time. If 0, lookahead analysis is disabled.
+lookahead_statements = 128
+
+# If True, image and audio files are read through the loader's I/O
+# scheduler, which orders reads by priority.
+io_scheduler = True
+
+# The largest file, in bytes, that the I/O scheduler reads into memory.
+# Larger files are streamed from disk as before.
+io_scheduler_max_read = 16 * 1024 * 1024
+
+# The number of phases listed in the log when startup is profiled.
+startup_profile_report = 20
+
+# The number of threads used to decode save thumbnails in the background.
+thumbnail_threads = 4
+
+# Should text be drawn as a signed distance field, with outlines and
+# shadows done in a shader?
+text_sdf = False
+
+# The minimum spread of text distance fields, in pixels.
+text_sdf_spread = 8
+
+# The number of frames an unused render-to-texture texture is kept in the
+# pool for, and the most memory the pool can use.
+rtt_pool_frames = 30
+rtt_pool_size = 64 * 1024 * 1024
+
+# Should gl2 record the GPU time, draw calls, and state changes of each
+# frame?
+gl_profile = False
+
+# The number of displayable and shader groups in the GPU profile that are
+# reported when config.profile is true.
+gl_profile_groups = 10
+
+# Should the mipmaps of loaded textures only be generated once they are
+# drawn minified?
+lazy_mipmaps = True
+
+# The most video memory, in bytes, that textures loaded from images should
+# use before the least recently drawn are evicted, or None for no limit.
+texture_budget = None
+
+# If greater than 1, images with more pixels than the drawable can show
+# are reduced by up to this factor when loaded.
+image_scale_variants = 1
+
+# Should PNG, JPEG, and WebP images be decoded by renpy.display.imagedecode,
+# rather than by pygame_sdl2?
+native_image_decode = True
+
+# Should im.Crop, im.Flip, im.Recolor, and im.Alpha be drawn as views of
+# the texture of the image they change, rather than as new images?
+image_views = True
+
+# The number of textures that flattened layered images are cached in.
+flatten_cache_size = 8
+
 
 del os
 del collections
@@ -142,6 +142,7 @@ Image = renpy.display.im.image
 Frame = renpy.display.imagelike.Frame
 Borders = renpy.display.imagelike.Borders
 Solid = renpy.display.imagelike.Solid
+SpriteSheet = renpy.display.imagelike.SpriteSheet
 FileCurrentScreenshot = renpy.display.imagelike.FileCurrentScreenshot
 
 LiveComposite = renpy.display.layout.LiveComposite
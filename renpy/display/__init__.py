@@ -80,10 +80,12 @@ if 1 == 0:
     from . import gesture
     from . import im
     from . import image
+    from . import imagedecode
     from . import imagelike
     from . import imagemap
     from . import joystick
     from . import layout
+    from . import layoutsupport
     from . import matrix
     from . import minigame
     from . import model
@@ -0,0 +1,179 @@
+# Copyright 2004-2023 Tom Rothamel <pytom@bishoujo.us>
+#
+# Permission is hereby granted, free of charge, to any person
+# obtaining a copy of this software and associated documentation files
+# (the "Software"), to deal in the Software without restriction,
+# including without limitation the rights to use, copy, modify, merge,
+# publish, distribute, sublicense, and/or sell copies of the Software,
+# and to permit persons to whom the Software is furnished to do so,
+# subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be
+# included in all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+# EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+# NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+# LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+# OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+# WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+# This captures the game to a video file. Frames are read back from gl2
+# asynchronously, and the mixed audio is taken from renpysound. Both are
+# encoded on background threads in renpysound.
+
+from __future__ import division, absolute_import, with_statement, print_function, unicode_literals
+from renpy.compat import PY2, basestring, bchr, bord, chr, open, pystr, range, round, str, tobytes, unicode # *
+
+import time
+
+import renpy
+
+# Are we capturing?
+capturing = False
+
+# The number of frames per second of the capture.
+fps = 60
+
+# Is the capture running with a fixed timestep?
+fixed = False
+
+# The size of the captured video.
+size = None
+
+# The time the capture started at.
+start_time = 0.0
+
+# The number of the last frame that was captured, or -1 if no frame has
+# been captured.
+last_frame = -1
+
+# The number of frames drawn in fixed mode.
+fixed_frames = 0
+
+
+def start(filename, fps=60, fixed=False, size=None):
+    """
+    Starts capturing to `filename`. See renpy.start_capture.
+    """
+
+    global capturing
+    global start_time
+    global last_frame
+    global fixed_frames
+
+    if capturing:
+        stop()
+
+    draw = renpy.display.draw
+
+    if (draw is None) or ("readback" not in draw.info):
+        raise Exception("Capturing video requires the gl2 renderer.")
+
+    if renpy.emscripten:
+        raise Exception("Capturing video is not supported on the web.")
+
+    if size is None:
+        x, y, w, h = draw.drawable_viewport
+        size = (int(w), int(h))
+
+    globals()["fps"] = fps
+    globals()["fixed"] = fixed
+    globals()["size"] = size
+
+    filename = renpy.exports.fsdecode(filename)
+
+    renpy.audio.renpysound.capture_start(
+        filename,
+        size[0],
+        size[1],
+        fps,
+        fixed=fixed,
+        max_queued_frames=renpy.config.capture_max_queued_frames)
+
+    capturing = True
+    last_frame = -1
+    fixed_frames = 0
+    start_time = time.time()
+
+    if fixed:
+        renpy.display.core.fixed_time = renpy.display.core.get_time()
+
+    renpy.display.log.write("Started capturing to %r at %dx%d, %d fps (fixed=%r).", filename, size[0], size[1], fps, fixed)
+
+
+def stop():
+    """
+    Stops the current capture, if any, and waits for the file to be
+    written.
+    """
+
+    global capturing
+
+    if not capturing:
+        return
+
+    # The readback callbacks only encode frames while capturing is true,
+    # so it's cleared once the frames in flight have been read back.
+    if renpy.display.draw is not None:
+        renpy.display.draw.finish_readbacks(True)
+
+    capturing = False
+
+    renpy.display.core.fixed_time = None
+
+    dropped = renpy.audio.renpysound.capture_stop()
+
+    if dropped < 0:
+        renpy.display.log.write("Capture failed while encoding.")
+    else:
+        renpy.display.log.write("Stopped capturing, %d frames dropped.", dropped)
+
+
+def before_flip(draw):
+    """
+    Called by gl2 after the screen has been drawn, but before it has been
+    flipped, to start reading the frame back.
+    """
+
+    global last_frame
+    global fixed_frames
+
+    if fixed:
+        frame = fixed_frames
+    else:
+        frame = int((time.time() - start_time) * fps)
+
+    # Don't encode two frames with the same timestamp.
+    if frame <= last_frame:
+        return
+
+    last_frame = frame
+
+    def callback(surf):
+        if capturing:
+            renpy.audio.renpysound.capture_video(surf, frame)
+
+    draw.screenshot_async(None, size, callback)
+
+
+def after_flip():
+    """
+    Called by gl2 after a frame has been flipped. In fixed mode, this
+    advances time by one frame, and mixes the audio for that frame.
+    """
+
+    global fixed_frames
+
+    if not fixed:
+        return
+
+    fixed_frames += 1
+
+    renpy.display.core.fixed_time += 1.0 / fps
+
+    freq = renpy.config.sound_sample_rate
+    samples = (fixed_frames * freq // fps) - ((fixed_frames - 1) * freq // fps)
+
+    renpy.audio.renpysound.capture_audio(samples)
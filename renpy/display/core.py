@@ -119,6 +119,10 @@ null = None
 time_base = 0.0
 time_mult = 1.0
 
+# If not None, the time returned by get_time. This is used to run the game
+# at a fixed timestep while capturing.
+fixed_time = None
+
 
 def init_layers():
     global layers, sticky_layers, null
@@ -143,6 +147,9 @@ def init_time():
 
 
 def get_time():
+    if fixed_time is not None:
+        return fixed_time
+
     t = time.time()
     return time_base + (t - time_base) * time_mult
 
@@ -1255,6 +1262,7 @@ class Renderer(object):
     - "resizable", true if the window can be resized.
     - "additive", true if additive blendering is supported.
     - "models", true if model-based rendering is being used.
+    - "readback", true if the renderer supports screenshot_async.
     """
 
     texture_cache = { }
@@ -1515,6 +1523,9 @@ class Interface(object):
         self.screenshot = None
         self.screenshot_surface = None
 
+        # The readback that will produce the screenshot, if it's still pending.
+        self.screenshot_readback = None
+
         self.old_scene = { }
         self.transition = { }
         self.suppress_transition = False
@@ -1948,6 +1959,8 @@ class Interface(object):
         Called after the first frame has been drawn.
         """
 
+        renpy.startupprofile.finish()
+
         if renpy.android:
             from jnius import autoclass
             PythonSDLActivity = autoclass("org.renpy.android.PythonSDLActivity")
@@ -2113,6 +2126,7 @@ class Interface(object):
         renpy.display.im.cache.clear()
         renpy.display.render.free_memory()
         renpy.text.text.layout_cache_clear()
+        renpy.display.layout.flatten_cache_clear()
         renpy.display.video.texture.clear()
 
     def kill_surfaces(self):
@@ -2258,10 +2272,32 @@ class Interface(object):
             surf = self.bgscreenshot_surface
             self.bgscreenshot_surface = None
 
+        elif renpy.display.draw.info.get("readback", False):
+
+            self.lose_screenshot()
+
+            # The surface is read back a frame or two later, so the
+            # screenshot doesn't stall the GPU.
+            self.screenshot_readback = renpy.display.draw.screenshot_async(
+                self.surftree,
+                scale,
+                lambda surf : self.store_screenshot(surf, scale))
+
+            return
+
         else:
 
             surf = renpy.display.draw.screenshot(self.surftree)
 
+        self.store_screenshot(surf, scale)
+
+    def store_screenshot(self, surf, scale):
+        """
+        Scales `surf` to `scale`, and stores it as the current screenshot.
+        """
+
+        self.screenshot_readback = None
+
         surf = renpy.display.scale.smoothscale(surf, scale)
 
         renpy.display.render.mutated_surface(surf)
@@ -2272,6 +2308,15 @@ class Interface(object):
             renpy.display.module.save_png(surf, sio, 0)
             self.screenshot = sio.getvalue()
 
+    def finish_screenshot(self):
+        """
+        If the screenshot is still being read back, waits for that to
+        finish. This must be called from the main thread.
+        """
+
+        if self.screenshot_readback is not None:
+            renpy.display.draw.finish_readbacks(True)
+
     def check_background_screenshot(self):
         """
         Handles requests for a background screenshot.
@@ -2291,6 +2336,9 @@ class Interface(object):
         if not self.started:
             return None
 
+        if threading.current_thread() is self.thread:
+            self.finish_screenshot()
+
         rv = self.screenshot
 
         if not rv:
@@ -2298,6 +2346,12 @@ class Interface(object):
                 (renpy.config.thumbnail_width, renpy.config.thumbnail_height),
                 background=(threading.current_thread() is not self.thread),
                 )
+
+            # On the main thread, the screenshot may be read back
+            # asynchronously, so wait for it.
+            if threading.current_thread() is self.thread:
+                self.finish_screenshot()
+
             rv = self.screenshot
             self.lose_screenshot()
 
@@ -2308,6 +2362,10 @@ class Interface(object):
         This deallocates the saved screenshot.
         """
 
+        if self.screenshot_readback is not None:
+            self.screenshot_readback.cancel()
+            self.screenshot_readback = None
+
         self.screenshot = None
         self.screenshot_surface = None
 
@@ -2598,7 +2656,7 @@ class Interface(object):
         This is called to handle the user invoking a quit.
         """
 
-        if self.screenshot is None:
+        if (self.screenshot is None) and (self.screenshot_readback is None):
             renpy.exports.take_screenshot()
 
         if self.quit_time > (time.time() - .75):
@@ -3687,6 +3745,9 @@ class Interface(object):
                 if self.maximum_framerate_time > get_time():
                     can_block = False
 
+                if renpy.display.capture.capturing:
+                    can_block = False
+
                 if (redraw_time is not None) and (not needs_redraw) and can_block:
                     if redraw_time != old_redraw_time:
                         time_left = redraw_time - get_time()
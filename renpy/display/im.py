@@ -29,7 +29,9 @@ from renpy.compat import PY2, basestring, bchr, bord, chr, open, pystr, range, r
 
 
 import math
+import struct
 import zipfile
+import zlib
 import threading
 import time
 import io
@@ -83,6 +85,29 @@ class CacheEntry(object):
 
         return rv
 
+
+class TextureReloader(object):
+    """
+    Reloads the surface a texture was created from, so the texture can be
+    loaded again after it's been evicted from video memory.
+    """
+
+    def __init__(self, image, bounds, size):
+        self.image = image
+        self.bounds = bounds
+        self.size = size
+
+    def __call__(self):
+        surf = self.image.load()
+
+        if self.bounds != (0, 0) + self.size:
+            surf = surf.subsurface(self.bounds)
+
+        renpy.display.render.mutated_surface(surf)
+
+        return surf
+
+
 # This is the singleton image cache.
 
 
@@ -191,6 +216,21 @@ class Cache(object):
         else:
             self.cache_limit = int(renpy.config.image_cache_size_mb * 1024 * 1024 // 4)
 
+    def after_fork(self):
+        """
+        Called in a child forked by the zygote, where the preload thread
+        doesn't exist. Recreates the locks, and restarts the thread.
+        """
+
+        self.lock = threading.Condition()
+        self.preload_lock = threading.Condition()
+        self.keep_preloading = True
+
+        if self.preload_thread is not None:
+            self.preload_thread = threading.Thread(target=self.preload_thread_main, name="preloader")
+            self.preload_thread.daemon = True
+            self.preload_thread.start()
+
     def quit(self): # @ReservedAssignment
         if not self.preload_thread:
             return
@@ -308,6 +348,13 @@ class Cache(object):
             if texture and (ce.texture is not None):
 
                 if predict:
+
+                    # If the texture has been evicted from video memory,
+                    # decode it again here, rather than when it's drawn.
+                    restore = getattr(ce.texture, "restore", None)
+                    if restore is not None:
+                        restore()
+
                     return None
 
                 if render:
@@ -377,6 +424,10 @@ class Cache(object):
 
                 ce.texture = renpy.display.draw.load_texture(texsurf)
 
+                set_reload = getattr(ce.texture, "set_reload", None)
+                if set_reload is not None:
+                    set_reload(TextureReloader(image, ce.bounds, (ce.width, ce.height)))
+
                 # This was loaded while predicting images for immediate use,
                 # so get it onto the GPU.
                 if not predict and renpy.display.draw is not None:
@@ -622,6 +673,33 @@ def free_memory():
     cache.clear()
 
 
+# The renderers that can draw views that need shaders.
+SHADER_RENDERERS = ( "gl2", "gles2", "angle2" )
+
+
+def use_views(shaders=False):
+    """
+    Returns true if image manipulators that can be drawn as views of the
+    render of their child should be. If `shaders` is true, the view needs
+    shaders to be drawn.
+    """
+
+    if not renpy.config.image_views:
+        return False
+
+    draw = renpy.display.draw
+
+    if draw is None:
+        return False
+
+    renderer = draw.info["renderer"]
+
+    if shaders:
+        return renderer in SHADER_RENDERERS
+
+    return renderer != "sw"
+
+
 class ImageBase(renpy.display.displayable.Displayable):
     """
     This is the base class for all of the various kinds of images that
@@ -713,6 +791,12 @@ class Image(ImageBase):
 
     is_svg = False
 
+    # A (factor, ScaledVariant) tuple, giving the variant last used to
+    # draw this image.
+    scaled_variant = None
+
+    nosave = [ "scaled_variant" ]
+
     def __init__(self, filename, **properties):
         """
         @param filename: The filename that the image will be loaded from.
@@ -731,6 +815,7 @@ class Image(ImageBase):
 
         super(Image, self).__init__(filename, **properties)
         self.filename = filename
+        self.is_svg = filename.lower().endswith(".svg")
 
 
     def _repr_info(self):
@@ -745,6 +830,49 @@ class Image(ImageBase):
         else:
             return self.oversample
 
+    def variant(self):
+        """
+        Returns the image that should be drawn in place of this one. When
+        config.image_scale_variants is true and the image has more pixels
+        than the drawable can show, this is a ScaledVariant that's been
+        reduced by a power of two. Otherwise, it's this image.
+        """
+
+        max_factor = renpy.config.image_scale_variants
+
+        if not max_factor or max_factor <= 1 or not self.cache:
+            return self
+
+        if self.is_svg:
+            return self
+
+        draw_per_virt = getattr(renpy.display.draw, "draw_per_virt", 1.0)
+
+        if draw_per_virt <= 0:
+            return self
+
+        # The number of image pixels per drawable pixel.
+        ratio = self.oversample / draw_per_virt
+
+        factor = 1
+
+        while (factor * 2 <= max_factor) and (factor * 2 <= ratio):
+            factor *= 2
+
+        if factor == 1:
+            return self
+
+        if (self.scaled_variant is None) or (self.scaled_variant[0] != factor):
+            self.scaled_variant = (factor, ScaledVariant(self, factor))
+
+        return self.scaled_variant[1]
+
+    def render(self, w, h, st, at):
+        return cache.get(self.variant(), render=True)
+
+    def predict_one(self):
+        renpy.display.predict.image(self.variant())
+
     def load(self, unscaled=False):
 
         # Unscaled is no longer used.
@@ -753,8 +881,15 @@ class Image(ImageBase):
 
         try:
 
+            # Images loaded by the preload thread are predicted, while the
+            # rest are needed for the current frame.
+            if threading.current_thread() is cache.preload_thread:
+                priority = renpy.loader.IO_PREDICT
+            else:
+                priority = renpy.loader.IO_IMAGE
+
             try:
-                filelike = renpy.loader.load(self.filename, directory="images")
+                filelike = renpy.loader.load(self.filename, directory="images", priority=priority)
                 filename = self.filename
                 force_size = None
             except renpy.webloader.DownloadNeeded as e:
@@ -817,6 +952,60 @@ class Image(ImageBase):
             return [ self.filename ]
 
 
+class ScaledVariant(ImageBase):
+    """
+    A version of an Image that's been reduced by `factor`, a power of two,
+    so that it needs less memory when drawn at a low resolution. The
+    oversample is reduced to match, so the image is drawn at the same size.
+
+    When loaded, the factor is halved until it evenly divides the width and
+    height of the image, so the variant is exactly the same size when drawn.
+    """
+
+    def __init__(self, im, factor, **properties):
+        super(ScaledVariant, self).__init__(im, factor, **properties)
+
+        self.image = im
+        self.factor = factor
+        self.oversample = im.get_oversample() / factor
+
+    def get_hash(self):
+        return self.image.get_hash()
+
+    def load(self):
+
+        # Load the image directly, rather than through the cache, so the
+        # full-size image doesn't take up space there.
+        surf = self.image.load()
+
+        width, height = surf.get_size()
+
+        factor = self.factor
+
+        while (factor > 1) and (width % factor or height % factor):
+            factor //= 2
+
+        self.factor = factor
+        self.oversample = self.image.get_oversample() / factor
+
+        if factor == 1:
+            return surf
+
+        width //= factor
+        height //= factor
+
+        try:
+            renpy.display.render.blit_lock.acquire()
+            rv = renpy.display.scale.smoothscale(surf, (width, height))
+        finally:
+            renpy.display.render.blit_lock.release()
+
+        return rv
+
+    def predict_files(self):
+        return self.image.predict_files()
+
+
 class Data(ImageBase):
     """
     :doc: im_im
@@ -846,24 +1035,100 @@ class Data(ImageBase):
         return renpy.display.pgrender.load_image(f, self.filename)
 
 
+# The executor that decodes ZipFileImages in the background, or None if
+# it hasn't been created yet.
+zip_executor = None
+
+
+def read_zip_member(zipfilename, member):
+    """
+    Reads a member of a zip file without reading the zip file's central
+    directory. `member` is a (header offset, compressed size, compression
+    type) tuple, as recorded from the member's ZipInfo.
+    """
+
+    offset, size, compress_type = member
+
+    with open(zipfilename, "rb") as f:
+        f.seek(offset)
+
+        header = f.read(zipfile.sizeFileHeader)
+        header = struct.unpack(zipfile.structFileHeader, header)
+
+        if header[zipfile._FH_SIGNATURE] != zipfile.stringFileHeader:
+            raise Exception("Bad zip file header in {}.".format(zipfilename))
+
+        f.seek(header[zipfile._FH_FILENAME_LENGTH] + header[zipfile._FH_EXTRA_FIELD_LENGTH], 1)
+
+        data = f.read(size)
+
+    if compress_type == zipfile.ZIP_DEFLATED:
+        data = zlib.decompress(data, -15)
+    elif compress_type != zipfile.ZIP_STORED:
+        raise Exception("Unsupported compression in {}.".format(zipfilename))
+
+    return data
+
+
 class ZipFileImage(ImageBase):
 
-    def __init__(self, zipfilename, filename, mtime=0, **properties):
+    # The location of the image in the zip file, if known.
+    member = None
+
+    # A future that's decoding the image in the background, if any.
+    future = None
+
+    nosave = [ "future" ]
+
+    def __init__(self, zipfilename, filename, mtime=0, member=None, **properties):
         super(ZipFileImage, self).__init__(zipfilename, filename, mtime, **properties)
 
         self.zipfilename = zipfilename
         self.filename = filename
+        self.member = member
 
-    def load(self):
+    def load_core(self):
         try:
-            with zipfile.ZipFile(self.zipfilename, 'r') as zf:
-                data = zf.read(self.filename)
-                sio = io.BytesIO(data)
-                rv = renpy.display.pgrender.load_image(sio, self.filename)
+            if self.member is not None:
+                data = read_zip_member(self.zipfilename, self.member)
+            else:
+                with zipfile.ZipFile(self.zipfilename, 'r') as zf:
+                    data = zf.read(self.filename)
+
+            sio = io.BytesIO(data)
+            rv = renpy.display.pgrender.load_image(sio, self.filename)
             return rv
         except Exception:
             return renpy.display.pgrender.surface((2, 2), True)
 
+    def load(self):
+
+        future = self.future
+
+        if future is not None:
+            self.future = None
+            return future.result()
+
+        return self.load_core()
+
+    def predict_one(self):
+        """
+        Starts decoding the image on the background executor, so images
+        like save thumbnails are decoded in parallel before they're needed.
+        """
+
+        global zip_executor
+
+        if (self.member is not None) and (self.future is None) and (not PY2) and renpy.config.thumbnail_threads:
+
+            if zip_executor is None:
+                import concurrent.futures
+                zip_executor = concurrent.futures.ThreadPoolExecutor(renpy.config.thumbnail_threads)
+
+            self.future = zip_executor.submit(self.load_core)
+
+        super(ZipFileImage, self).predict_one()
+
     def predict_files(self):
         return [ ]
 
@@ -1106,6 +1371,30 @@ class Flip(ImageBase):
 
         return rv
 
+    def render(self, w, h, st, at):
+
+        if not use_views():
+            return cache.get(self, render=True)
+
+        # Draw the child's texture flipped, rather than flipping a copy.
+        cr = renpy.display.render.render(self.image, w, h, st, at)
+        width, height = cr.get_size()
+
+        xzoom = -1 if self.horizontal else 1
+        yzoom = -1 if self.vertical else 1
+
+        rv = renpy.display.render.Render(width, height)
+        rv.forward = rv.reverse = renpy.display.matrix.Matrix2D(xzoom, 0, 0, yzoom)
+        rv.blit(cr, (width if self.horizontal else 0, height if self.vertical else 0))
+
+        return rv
+
+    def predict_one(self):
+        if use_views():
+            self.image.predict_one()
+        else:
+            renpy.display.predict.image(self)
+
     def predict_files(self):
         return self.image.predict_files()
 
@@ -1192,6 +1481,21 @@ class Crop(ImageBase):
         return cache.get(self.image).subsurface((self.x*os, self.y*os,
                                                  self.w*os, self.h*os))
 
+    def render(self, w, h, st, at):
+
+        if not use_views():
+            return cache.get(self, render=True)
+
+        # Crop the child's render, so the crop shares its texture.
+        cr = renpy.display.render.render(self.image, w, h, st, at)
+        return cr.subsurface((self.x, self.y, self.w, self.h))
+
+    def predict_one(self):
+        if use_views():
+            self.image.predict_one()
+        else:
+            renpy.display.predict.image(self)
+
     def predict_files(self):
         return self.image.predict_files()
 
@@ -1347,6 +1651,41 @@ class Recolor(ImageBase):
 
         return rv
 
+    def render(self, w, h, st, at):
+
+        if not use_views(shaders=True):
+            return cache.get(self, render=True)
+
+        # Recolor the child's texture with a shader. Linmap multiplies each
+        # channel by mul / 256, and the color matrix is applied to
+        # premultiplied colors, so the alpha factor is applied to each
+        # of the color channels.
+        cr = renpy.display.render.render(self.image, w, h, st, at)
+        width, height = cr.get_size()
+
+        r = self.rmul / 256.0
+        g = self.gmul / 256.0
+        b = self.bmul / 256.0
+        a = self.amul / 256.0
+
+        rv = renpy.display.render.Render(width, height)
+        rv.add_shader("renpy.matrixcolor")
+        rv.add_uniform("u_renpy_matrixcolor", renpy.display.matrix.Matrix([
+            r * a, 0, 0, 0,
+            0, g * a, 0, 0,
+            0, 0, b * a, 0,
+            0, 0, 0, a,
+            ]))
+        rv.blit(cr, (0, 0))
+
+        return rv
+
+    def predict_one(self):
+        if use_views(shaders=True):
+            self.image.predict_one()
+        else:
+            renpy.display.predict.image(self)
+
     def predict_files(self):
         return self.image.predict_files()
 
@@ -44,6 +44,95 @@ image_attributes = collections.defaultdict(dict)
 # The set of image names Ren'Py knows about, as strings with spaces.
 image_names = [ ]
 
+# A map from image tag to the AttributeIndex of the images with that tag.
+# An index is removed when an image with its tag is registered, and built
+# again the next time it's needed.
+attribute_indexes = { }
+
+
+class AttributeIndex(object):
+    """
+    An index of the images with a tag. This maps each attribute to a bitset
+    of the images with that attribute, so the images that have a set of
+    attributes can be found by intersecting bitsets, rather than by checking
+    every image.
+    """
+
+    def __init__(self, tag):
+
+        # A list of (attributes, displayable) tuples, one for each image
+        # with the tag, in the order they were registered. Bit i of a
+        # bitset refers to self.images[i].
+        self.images = list(image_attributes.get(tag, { }).items())
+
+        # A bitset of every image.
+        self.all = (1 << len(self.images)) - 1
+
+        # A map from an attribute to the bitset of images with it.
+        self.attribute_bits = { }
+
+        # A bitset of the images that choose their own attributes, like
+        # layered images.
+        self.choose_bits = 0
+
+        for i, (attrs, d) in enumerate(self.images):
+            bit = 1 << i
+
+            for a in attrs:
+                self.attribute_bits[a] = self.attribute_bits.get(a, 0) | bit
+
+            if getattr(d, "_choose_attributes", None) is not None:
+                self.choose_bits |= bit
+
+        # A map from (attributes, sort) to the result of
+        # get_ordered_image_attributes.
+        self.ordered = { }
+
+    def having(self, attributes):
+        """
+        Returns the bitset of images that have all of `attributes`.
+        """
+
+        rv = self.all
+
+        for a in attributes:
+            rv &= self.attribute_bits.get(a, 0)
+
+            if not rv:
+                break
+
+        return rv
+
+    def select(self, bits):
+        """
+        Returns a list of the (attributes, displayable) tuples of the images
+        in `bits`, in the order they were registered.
+        """
+
+        images = self.images
+        rv = [ ]
+
+        while bits:
+            low = bits & -bits
+            rv.append(images[low.bit_length() - 1])
+            bits ^= low
+
+        return rv
+
+
+def get_attribute_index(tag):
+    """
+    Returns the AttributeIndex for `tag`, building it if required.
+    """
+
+    rv = attribute_indexes.get(tag, None)
+
+    if rv is None:
+        rv = AttributeIndex(tag)
+        attribute_indexes[tag] = rv
+
+    return rv
+
 
 def list_images():
     """
@@ -76,19 +165,12 @@ def get_available_image_attributes(tag, attributes=()):
     in that iterable are returned.
     """
 
-    rv = [ ]
-
     if tag not in image_attributes:
-        return rv
+        return [ ]
 
-    for at in image_attributes[tag]:
-        for a in attributes:
-            if a not in at:
-                break
-        else:
-            rv.append(at)
+    index = get_attribute_index(tag)
 
-    return rv
+    return [ attrs for attrs, _d in index.select(index.having(attributes)) ]
 
 
 def get_tag_method(tag, method):
@@ -120,7 +202,13 @@ def check_image_attributes(tag, attributes):
 
     l = [ ]
 
-    for attrs, d in image_attributes[tag].items():
+    index = get_attribute_index(tag)
+
+    # Only images with all the attributes, or that choose attributes, can
+    # match.
+    candidates = index.having(attributes) | index.choose_bits
+
+    for attrs, d in index.select(candidates):
 
         remainder = [ i for i in attributes if i not in attrs ]
 
@@ -171,6 +259,29 @@ def get_ordered_image_attributes(tag, attributes=(), sort=None):
         for more information.
     """
 
+    index = get_attribute_index(tag)
+
+    key = (tuple(attributes), sort)
+
+    rv = index.ordered.get(key, None)
+
+    if rv is None:
+        rv = compute_ordered_image_attributes(tag, attributes, sort)
+
+        if len(index.ordered) >= 64:
+            index.ordered.clear()
+
+        index.ordered[key] = rv
+
+    return list(rv)
+
+
+def compute_ordered_image_attributes(tag, attributes, sort):
+    """
+    Does the work of get_ordered_image_attributes, which caches the
+    result.
+    """
+
     sequences = [ ]
 
     attrcount = collections.defaultdict(int)
@@ -263,6 +374,8 @@ def register_image(name, d):
     images[name] = d
     image_attributes[tag][rest] = d
 
+    attribute_indexes.pop(tag, None)
+
     image_names.append(" ".join(name))
 
 
@@ -997,7 +1110,13 @@ class ShownImageInfo(renpy.object.Object):
         # The list of matching images.
         matches = None
 
-        for attrs, d in image_attributes[tag].items():
+        index = get_attribute_index(tag)
+
+        # Only images with all the required attributes, or that choose
+        # attributes, can match.
+        candidates = index.having(required) | index.choose_bits
+
+        for attrs, d in index.select(candidates):
 
             if not all((i in required) or (i in optional) for i in attrs):
                 continue
@@ -0,0 +1,99 @@
+#cython: profile=False
+# Copyright 2004-2023 Tom Rothamel <pytom@bishoujo.us>
+#
+# Permission is hereby granted, free of charge, to any person
+# obtaining a copy of this software and associated documentation files
+# (the "Software"), to deal in the Software without restriction,
+# including without limitation the rights to use, copy, modify, merge,
+# publish, distribute, sublicense, and/or sell copies of the Software,
+# and to permit persons to whom the Software is furnished to do so,
+# subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be
+# included in all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+# EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+# NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+# LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+# OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+# WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+# This decodes PNG, JPEG, and WebP images with libpng, libjpeg-turbo, and
+# libwebp, straight into the pixels of a surface in the format the texture
+# loader uploads, without holding the GIL. Images that can't be decoded
+# this way are left to pygame_sdl2.
+
+from __future__ import print_function
+
+import sys
+
+from sdl2 cimport *
+from pygame_sdl2 cimport *
+import_pygame_sdl2()
+
+cdef extern from "imagedecode.h":
+
+    int IMAGEDECODE_UNKNOWN
+
+    int imagedecode_format(const unsigned char *data, size_t length) nogil
+    int imagedecode_supported(int format) nogil
+    int imagedecode_info(const unsigned char *data, size_t length, int *width, int *height) nogil
+    int imagedecode_decode(const unsigned char *data, size_t length, unsigned char *pixels, int pitch, int width, int height) nogil
+
+# The masks of a surface with its pixels in RGBA byte order.
+if sys.byteorder == "little":
+    RGBA_MASKS = (0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000)
+else:
+    RGBA_MASKS = (0xff000000, 0x00ff0000, 0x0000ff00, 0x000000ff)
+
+
+def supported(bytes data):
+    """
+    Returns true if `data` is in a format that can be decoded here.
+    """
+
+    cdef const unsigned char *p = data
+
+    return bool(imagedecode_supported(imagedecode_format(p, len(data))))
+
+
+def decode(bytes data, make_surface):
+    """
+    Decodes the image in `data`. `make_surface` is called with a (width,
+    height) tuple, and should return a 32-bit surface with an alpha
+    channel. Returns that surface with the image decoded into it, or None
+    if the image can't be decoded here.
+    """
+
+    cdef const unsigned char *p = data
+    cdef size_t length = len(data)
+    cdef int width
+    cdef int height
+    cdef int rv
+    cdef SDL_Surface *s
+
+    if not imagedecode_supported(imagedecode_format(p, length)):
+        return None
+
+    with nogil:
+        rv = imagedecode_info(p, length, &width, &height)
+
+    if rv or width <= 0 or height <= 0:
+        return None
+
+    surf = make_surface((width, height))
+
+    if tuple(i & 0xffffffff for i in surf.get_masks()) != RGBA_MASKS:
+        return None
+
+    s = PySurface_AsSurface(surf)
+
+    with nogil:
+        rv = imagedecode_decode(p, length, <unsigned char *> s.pixels, s.pitch, width, height)
+
+    if rv:
+        return None
+
+    return surf
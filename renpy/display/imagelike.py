@@ -145,6 +145,100 @@ class Borders(object):
             )
 
 
+# A cache of the meshes used to draw Frames with gl2, keyed on the size of
+# the frame and its child, the borders, and the tiling. A value of False
+# means the frame can't be drawn as a single mesh.
+frame_mesh_cache = { }
+
+# The number of entries frame_mesh_cache can grow to before it's cleared.
+frame_mesh_cache_size = 256
+
+
+def frame_texture(crend):
+    """
+    If `crend` is a Render that only draws a single gl2 texture, scaled to
+    cover it exactly, returns the texture. Otherwise, returns None, and the
+    child has to be rendered to a texture before a frame mesh can use it.
+    """
+
+    if not isinstance(crend, Render):
+        return None
+
+    if len(crend.children) != 1:
+        return None
+
+    if crend.mesh or crend.shaders or crend.uniforms or crend.properties:
+        return None
+
+    if crend.operation != renpy.display.render.BLIT:
+        return None
+
+    if crend.alpha != 1.0 or crend.over != 1.0 or crend.nearest:
+        return None
+
+    tex, x, y, _focus, _main = crend.children[0]
+
+    if x or y:
+        return None
+
+    if not isinstance(tex, renpy.gl2.gl2texture.GLTexture):
+        return None
+
+    cw, ch = crend.get_size()
+    tw, th = tex.get_size()
+
+    forward = crend.forward
+
+    if forward is None:
+        xscale = 1.0
+        yscale = 1.0
+    else:
+        if forward.xdy or forward.ydx:
+            return None
+
+        xscale = forward.xdx
+        yscale = forward.ydy
+
+    if abs(cw * xscale - tw) > 0.5 or abs(ch * yscale - th) > 0.5:
+        return None
+
+    return tex
+
+
+def frame_segments(d0, cd, s0, cs, tile, tile_ratio):
+    """
+    Splits a part of a frame along one axis into segments. `d0` and `cd`
+    are the start and size of the part in the destination, and `s0` and
+    `cs` are the start and size in the source. Returns a list of
+    (d0, d1, s0, s1) tuples.
+    """
+
+    if (not tile) or (cd == cs):
+        return [ (d0, d0 + cd, s0, s0 + cs) ]
+
+    tiles = max(1, cd // cs + (1 if cd % cs else 0))
+
+    if cd % cs and tile == "integer":
+
+        # Stretch or shrink an integer number of tiles to fit.
+        if cd % cs / float(cs) < tile_ratio:
+            tiles = max(1, tiles - 1)
+
+        step = 1.0 * cd / tiles
+
+        return [ (d0 + i * step, d0 + (i + 1) * step, s0, s0 + cs) for i in range(tiles) ]
+
+    rv = [ ]
+
+    # Repeat the tile, trimming the last one.
+    for i in range(tiles):
+        start = i * cs
+        end = min(cd, start + cs)
+        rv.append((d0 + start, d0 + end, s0, s0 + end - start))
+
+    return rv
+
+
 class Frame(renpy.display.displayable.Displayable):
     """
     :doc: disp_imagelike
@@ -325,6 +419,12 @@ class Frame(renpy.display.displayable.Displayable):
         if renpy.display.draw.info["renderer"] == "sw":
             return self.sw_render(crend, dw, dh, left, top, right, bottom)
 
+        if renpy.display.render.models:
+            rv = self.mesh_render(crend, dw, dh, sw, sh, left, top, right, bottom)
+
+            if rv is not None:
+                return rv
+
         def draw(x0, x1, y0, y1):
 
             # Compute the coordinates of the left, right, top, and
@@ -430,6 +530,101 @@ class Frame(renpy.display.displayable.Displayable):
 
         return rv
 
+    def mesh_render(self, crend, dw, dh, sw, sh, left, top, right, bottom):
+        """
+        Renders the frame as a single gl2 mesh, with the nine (or more, if
+        tiling) parts of the frame drawn from one texture of `crend`.
+        Returns None if this isn't possible.
+        """
+
+        cw, ch = crend.get_size()
+
+        key = (dw, dh, cw, ch, left, top, right, bottom, self.tile, self.tile_ratio)
+
+        mesh = frame_mesh_cache.get(key, None)
+
+        if mesh is None:
+
+            rectangles = [ ]
+
+            def draw(x0, x1, y0, y1):
+
+                if x0 >= 0:
+                    dx0 = x0
+                    sx0 = x0
+                else:
+                    dx0 = dw + x0
+                    sx0 = sw + x0
+
+                if x1 > 0:
+                    dx1 = x1
+                    sx1 = x1
+                else:
+                    dx1 = dw + x1
+                    sx1 = sw + x1
+
+                if y0 >= 0:
+                    dy0 = y0
+                    sy0 = y0
+                else:
+                    dy0 = dh + y0
+                    sy0 = sh + y0
+
+                if y1 > 0:
+                    dy1 = y1
+                    sy1 = y1
+                else:
+                    dy1 = dh + y1
+                    sy1 = sh + y1
+
+                csw = sx1 - sx0
+                csh = sy1 - sy0
+                cdw = dx1 - dx0
+                cdh = dy1 - dy0
+
+                if csw <= 0 or csh <= 0 or cdh <= 0 or cdw <= 0:
+                    return
+
+                xsegments = frame_segments(dx0, cdw, sx0, csw, self.tile, self.tile_ratio)
+                ysegments = frame_segments(dy0, cdh, sy0, csh, self.tile, self.tile_ratio)
+
+                for pl, pr, tl, tr in xsegments:
+                    for pb, pt, tb, tt in ysegments:
+                        rectangles.append((pl, pb, pr, pt, 1.0 * tl / cw, 1.0 * tb / ch, 1.0 * tr / cw, 1.0 * tt / ch))
+
+            self.draw_pattern(draw, left, top, right, bottom)
+
+            # Each rectangle takes four points, and points are indexed by
+            # unsigned shorts.
+            if (not rectangles) or (len(rectangles) * 4 > 65535):
+                mesh = False
+            else:
+                mesh = renpy.gl2.gl2mesh2.Mesh2.texture_rectangles(rectangles)
+
+            if len(frame_mesh_cache) >= frame_mesh_cache_size:
+                frame_mesh_cache.clear()
+
+            frame_mesh_cache[key] = mesh
+
+        if mesh is False:
+            return None
+
+        # When the child is a single texture, the mesh draws from it
+        # directly, rather than from a copy of the child rendered to a
+        # texture.
+        source = frame_texture(crend)
+
+        if source is None:
+            source = crend
+
+        rv = Render(dw, dh)
+        rv.blit(source, (0, 0), focus=False)
+
+        rv.mesh = mesh
+        rv.add_shader("renpy.texture")
+
+        return rv
+
     def draw_pattern(self, draw, left, top, right, bottom):
         # Top row.
         if top:
@@ -605,6 +800,164 @@ class Frame(renpy.display.displayable.Displayable):
         return rv
 
 
+class SpriteSheet(renpy.display.displayable.Displayable):
+    """
+    :doc: disp_imagelike
+    :args: (image, frame_size, frames=None, *, delay=None, loop=True, **properties)
+    :name: SpriteSheet
+
+    A displayable that shows frames cut out of a sprite sheet. The sheet
+    is loaded and uploaded to the GPU once, and each frame is drawn from
+    part of it, so switching between frames doesn't load or copy anything.
+
+    `image`
+        The sprite sheet. This should be an image, like a filename or an
+        image manipulator.
+
+    `frame_size`
+        A (width, height) tuple giving the size of each frame. The frames
+        are numbered from 0, left to right and then top to bottom.
+
+    `frames`
+        If None, all the frames in the sheet are shown. If an integer,
+        this many frames are shown, starting with frame 0. Otherwise, a
+        list of frame numbers, which are shown in order.
+
+    `delay`
+        If not None, the frames are shown as an animation, changing every
+        `delay` seconds. If None, only the first frame is shown.
+
+    `loop`
+        If true, the animation repeats. Otherwise, it stops on its last
+        frame.
+
+    A SpriteSheet has a frame method, that takes a frame number and
+    returns a SpriteSheet that shows only that frame.
+
+    ::
+
+        image eileen walk = SpriteSheet("eileen_walk.png", (128, 256), delay=0.1)
+
+        define items = SpriteSheet("items.png", (32, 32))
+        image coin = items.frame(4)
+    """
+
+    def __init__(self, image, frame_size, frames=None, delay=None, loop=True, **properties):
+        super(SpriteSheet, self).__init__(**properties)
+
+        self.image = renpy.easy.displayable(image)
+        self._duplicatable = self.image._duplicatable
+        self.frame_size = tuple(frame_size)
+        self.frames = frames
+        self.delay = delay
+        self.loop = loop
+
+    def __repr__(self):
+        return "<SpriteSheet {!r} {}x{}>".format(self.image, self.frame_size[0], self.frame_size[1])
+
+    def __eq__(self, o):
+        if not self._equals(o):
+            return False
+
+        if self.image != o.image:
+            return False
+
+        return (self.frame_size, self.frames, self.delay, self.loop) == (o.frame_size, o.frames, o.delay, o.loop)
+
+    def frame(self, n):
+        """
+        Returns a displayable that shows frame `n` of the sprite sheet.
+        """
+
+        return SpriteSheet(self.image, self.frame_size, [ n ], style=self.style)
+
+    def get_frames(self, width, height):
+        """
+        Returns the list of frame numbers to show, given that the sheet
+        is `width` by `height`.
+        """
+
+        fw, fh = self.frame_size
+
+        columns = max(1, int(width // fw))
+        count = columns * max(1, int(height // fh))
+
+        if self.frames is None:
+            return list(range(count))
+        elif isinstance(self.frames, int):
+            return list(range(self.frames))
+        else:
+            return list(self.frames)
+
+    def render(self, width, height, st, at):
+
+        sheet = render(self.image, width, height, st, at)
+        sw, sh = sheet.get_size()
+
+        fw, fh = self.frame_size
+        columns = max(1, int(sw // fw))
+
+        frames = self.get_frames(sw, sh)
+
+        if not frames:
+            return Render(fw, fh)
+
+        index = 0
+
+        if self.delay and len(frames) > 1:
+            index = int(st // self.delay)
+
+            if self.loop:
+                index %= len(frames)
+                renpy.display.render.redraw(self, self.delay - (st % self.delay))
+            elif index < len(frames) - 1:
+                renpy.display.render.redraw(self, self.delay - (st % self.delay))
+            else:
+                index = len(frames) - 1
+
+        n = frames[index]
+
+        x = (n % columns) * fw
+        y = (n // columns) * fh
+
+        # The subsurface of the sheet's render refers to part of the sheet's
+        # texture, rather than copying it.
+        rv = sheet.subsurface((x, y, fw, fh))
+        rv.depends_on(sheet)
+
+        return rv
+
+    def _duplicate(self, args):
+        image = self.image._duplicate(args)
+
+        if image is self.image:
+            return self
+
+        image._unique()
+
+        rv = self._copy(args)
+        rv.image = image
+        rv._duplicatable = image._duplicatable
+        return rv
+
+    def _unique(self):
+        self.image._unique()
+        self._duplicatable = False
+
+    def _in_current_store(self):
+        image = self.image._in_current_store()
+
+        if image is self.image:
+            return self
+
+        rv = self._copy()
+        rv.image = image
+        return rv
+
+    def visit(self):
+        return [ self.image ]
+
+
 class FileCurrentScreenshot(renpy.display.displayable.Displayable):
     """
     :doc: file_action_function
@@ -628,6 +981,8 @@ class FileCurrentScreenshot(renpy.display.displayable.Displayable):
 
     def render(self, width, height, st, at):
 
+        renpy.display.interface.finish_screenshot()
+
         ss = renpy.display.interface.screenshot_surface
 
         if ss is None:
@@ -25,6 +25,8 @@
 from __future__ import division, absolute_import, with_statement, print_function, unicode_literals
 from renpy.compat import PY2, basestring, bchr, bord, chr, open, pystr, range, round, str, tobytes, unicode # *
 
+import collections
+
 import pygame_sdl2 as pygame
 
 import renpy
@@ -495,40 +497,12 @@ class Grid(Container):
         if self.style.yfill:
             renheight = (height - (rows - 1) * yspacing - top_margin - bottom_margin) // rows
 
-        renders = [ render(i, renwidth, renheight, st, at) for i in children ]
-        sizes = [ i.get_size() for i in renders ]
-
-        cwidth = 0
-        cheight = 0
-
-        for w, h in sizes:
-            cwidth = max(cwidth, w)
-            cheight = max(cheight, h)
-
-        if self.style.xfill:
-            cwidth = renwidth
-
-        if self.style.yfill:
-            cheight = renheight
-
-        width = cwidth * cols + xspacing * (cols - 1) + left_margin + right_margin
-        height = cheight * rows + yspacing * (rows - 1) + top_margin + bottom_margin
-
-        rv = renpy.display.render.Render(width, height)
-
-        offsets = [ ]
-
-        for y in range(0, rows):
-            for x in range(0, cols):
-
-                child = children[ x + y * cols ]
-                surf = renders[x + y * cols]
-
-                xpos = x * (cwidth + xspacing) + left_margin
-                ypos = y * (cheight + yspacing) + top_margin
-
-                offset = child.place(rv, xpos, ypos, cwidth, cheight, surf)
-                offsets.append(offset)
+        rv, offsets = renpy.display.layoutsupport.grid_layout(
+            children, cols, rows, renwidth, renheight,
+            self.style.xfill, self.style.yfill,
+            xspacing, yspacing,
+            left_margin, right_margin, top_margin, bottom_margin,
+            st, at)
 
         if self.transpose:
             self.offsets = [ ]
@@ -944,220 +918,16 @@ class MultiBox(Container):
 
         spacings = [ first_spacing ] + [ spacing ] * (len(self.children) - 1)
 
-        box_wrap = self.style.box_wrap
-        box_wrap_spacing = self.style.box_wrap_spacing
-        xfill = self.style.xfill
-        yfill = self.style.yfill
-        xminimum = self.style.xminimum
-        yminimum = self.style.yminimum
-
-        # The shared height and width of the current line. The line_height must
-        # be 0 for a vertical box, and the line_width must be 0 for a horizontal
-        # box.
-        line_width = 0
-        line_height = 0
-
-        # The children to layout.
-        children = list(self.children)
-        if self.style.box_reverse and renpy.config.simple_box_reverse:
-            children.reverse()
-            spacings.reverse()
-
-        # a list of (child, x, y, w, h, surf) tuples that are turned into
-        # calls to child.place().
-        placements = [ ]
-
-        # The maximum x and y.
-        maxx = 0
-        maxy = 0
-
-        # The minimum size of x and y.
-        minx = 0
-        miny = 0
-
-        def layout_line(line, xfill, yfill):
-            """
-            Lays out a single line.
-
-            `line` a list of (child, x, y, surf) tuples.
-            `xfill` the amount of space to add in the x direction.
-            `yfill` the amount of space to add in the y direction.
-            """
-
-            xfill = max(0, xfill)
-            yfill = max(0, yfill)
-
-            if renpy.config.box_skip:
-                line_count = len([i for i in line if not i[0]._box_skip])
-            else:
-                line_count = len(line)
-
-            if line_count > 0:
-                xperchild = xfill // line_count
-                yperchild = yfill // line_count
-            else:
-                xperchild = 0
-                yperchild = 0
-
-            maxxout = maxx
-            maxyout = maxy
-
-            i = 0
-
-            for child, x, y, surf in line:
-
-                sw, sh = surf.get_size()
-                sw = max(line_width, sw)
-                sh = max(line_height, sh)
-
-                if (not child._box_skip) or (not renpy.config.box_skip):
-
-                    x += i * xperchild
-                    y += i * yperchild
-
-                    sw += xperchild
-                    sh += yperchild
-
-                    i += 1
-
-                placements.append((child, x, y, sw, sh, surf))
-
-                maxxout = max(maxxout, x + sw)
-                maxyout = max(maxyout, y + sh)
-
-            return maxxout, maxyout
-
-        x = 0
-        y = 0
-
         if layout == "horizontal":
-
-            if yfill:
-                miny = height
-            else:
-                miny = yminimum
-
-            line_height = 0
-            line = [ ]
-            remwidth = width
-
-            if xfill:
-                target_width = width
-            else:
-                target_width = xminimum
-
-            for d, padding, cst, cat in zip(children, spacings, csts, cats):
-
-                if d._box_skip and renpy.config.box_skip:
-                    padding = 0
-
-                if box_wrap:
-                    rw = width
-                else:
-                    rw = remwidth
-
-                surf = render(d, rw, height - y, cst, cat)
-                sw, sh = surf.get_size()
-
-                if box_wrap and remwidth - sw - padding < 0 and line:
-                    maxx, maxy = layout_line(line, (target_width - x), 0)
-
-                    y += line_height + box_wrap_spacing
-                    x = 0
-                    line_height = 0
-                    remwidth = width
-                    line = [ ]
-
-                line.append((d, x, y, surf))
-                line_height = max(line_height, sh)
-                x += sw + padding
-                remwidth -= (sw + padding)
-
-            maxx, maxy = layout_line(line, (target_width - x) if (not box_wrap) else 0, 0)
-
+            vertical = False
         elif layout == "vertical":
-
-            if xfill:
-                minx = width
-            else:
-                minx = xminimum
-
-            line_width = 0
-            line = [ ]
-            remheight = height
-
-            if yfill:
-                target_height = height
-            else:
-                target_height = yminimum
-
-            for d, padding, cst, cat in zip(children, spacings, csts, cats):
-
-                if d._box_skip and renpy.config.box_skip:
-                    padding = 0
-
-                if box_wrap:
-                    rh = height
-                else:
-                    rh = remheight
-
-                surf = render(d, width - x, rh, cst, cat)
-                sw, sh = surf.get_size()
-
-                if box_wrap and remheight - sh - padding < 0:
-                    maxx, maxy = layout_line(line, 0, (target_height - y))
-
-                    x += line_width + box_wrap_spacing
-                    y = 0
-                    line_width = 0
-                    remheight = height
-                    line = [ ]
-
-                line.append((d, x, y, surf))
-                line_width = max(line_width, sw)
-                y += sh + padding
-                remheight -= (sh + padding)
-
-            maxx, maxy = layout_line(line, 0, (target_height - y) if (not box_wrap) else 0)
-
+            vertical = True
         else:
             raise Exception("Unknown box layout: %r" % layout)
 
-        # Back to the common for vertical and horizontal.
-
-        if not xfill:
-            width = max(xminimum, maxx)
-
-        if not yfill:
-            height = max(yminimum, maxy)
-
-        if self.style.box_reverse and not renpy.config.simple_box_reverse:
-            new_placements = [ ]
-
-            for child, x, y, w, h, surf in placements:
-                if layout == "vertical":
-                    new_placements.append((child, x, height - y - h, w, h, surf))
-                else:
-                    new_placements.append((child, width - x - w, y, w, h, surf))
-
-            placements = new_placements
-
-        rv = renpy.display.render.Render(width, height)
-
-        if self.style.order_reverse ^ (self.style.box_reverse and renpy.config.simple_box_reverse):
-            placements.reverse()
-
-        for child, x, y, w, h, surf in placements:
-            w = max(minx, w)
-            h = max(miny, h)
-
-            offset = child.place(rv, x, y, w, h, surf)
-            offsets.append(offset)
-
-        if self.style.order_reverse:
-            offsets.reverse()
-
-        self.offsets = offsets
+        # The measurement and placement is done by layoutsupport.
+        rv, self.offsets = renpy.display.layoutsupport.box_layout(
+            list(self.children), spacings, csts, cats, vertical, width, height, self.style)
 
         return rv
 
@@ -2217,6 +1987,115 @@ class Flatten(Container):
         return self.child.get_placement()
 
 
+# A map from the key of a CachedFlatten to the texture it was flattened
+# into, with the least recently drawn first.
+flatten_cache = collections.OrderedDict()
+
+
+def flatten_cache_clear():
+    flatten_cache.clear()
+
+
+class CachedFlatten(Container):
+    """
+    :undocumented:
+
+    Like Flatten, this flattens `child` into a single texture, but that
+    texture is cached, and drawn again without rendering `child` while
+    nothing that affects it has changed.
+
+    `key`
+        A hashable value identifying everything that determines how
+        `child` looks, apart from `conditions`.
+
+    `conditions`
+        A list of strings giving Python conditions, as used by
+        ConditionSwitch, that determine which parts of `child` are
+        shown. These are evaluated each time the displayable is rendered,
+        and the cached texture is only used if they have the same values.
+
+    Since `child` isn't rendered while its texture is cached, it shouldn't
+    change over time.
+    """
+
+    def __init__(self, child, key, conditions=[ ], **properties):
+        super(CachedFlatten, self).__init__(**properties)
+
+        self.add(child)
+
+        self.key = key
+        self.conditions = list(conditions)
+
+    def get_key(self, width, height):
+
+        values = [ ]
+
+        for cond in self.conditions:
+
+            if cond in cond_cache:
+                code = cond_cache[cond]
+            else:
+                code = renpy.python.py_compile(cond, 'eval')
+                cond_cache[cond] = code
+
+            values.append(bool(renpy.python.py_eval_bytecode(code)))
+
+        return (self.key, tuple(values), width, height)
+
+    def render(self, width, height, st, at):
+
+        key = self.get_key(width, height)
+
+        tex = flatten_cache.pop(key, None)
+
+        if tex is None:
+            cr = render(self.child, width, height, st, at)
+            cw, ch = cr.get_size()
+
+            if (cw <= 0) or (ch <= 0):
+                self.offsets = [ (0, 0) ]
+                return cr
+
+            load_all_textures = getattr(renpy.display.draw, "load_all_textures", None)
+
+            # The textures making up the child have to be loaded before
+            # they're drawn into the cached texture. Renderers that can't
+            # load them up front flatten the child each frame instead.
+            if load_all_textures is None:
+                rv = Render(cw, ch)
+                rv.blit(cr, (0, 0))
+
+                rv.operation = renpy.display.render.FLATTEN
+
+                rv.mesh = True
+                rv.add_shader("renpy.texture")
+                rv.add_property("mipmap", renpy.config.mipmap_dissolves if (self.style.mipmap is None) else self.style.mipmap)
+
+                self.offsets = [ (0, 0) ]
+
+                return rv
+
+            load_all_textures(cr)
+            tex = cr.render_to_texture(True)
+
+        flatten_cache[key] = tex
+
+        while len(flatten_cache) > renpy.config.flatten_cache_size:
+            flatten_cache.popitem(last=False)
+
+        cw, ch = tex.get_size()
+
+        rv = Render(cw, ch)
+        rv.blit(tex, (0, 0))
+
+        self.offsets = [ (0, 0) ]
+
+        return rv
+
+    def get_placement(self):
+        return self.child.get_placement()
+
+
 class AlphaMask(Container):
     """
     :doc: disp_imagelike
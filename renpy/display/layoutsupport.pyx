@@ -0,0 +1,389 @@
+#cython: profile=False
+# Copyright 2004-2023 Tom Rothamel <pytom@bishoujo.us>
+#
+# Permission is hereby granted, free of charge, to any person
+# obtaining a copy of this software and associated documentation files
+# (the "Software"), to deal in the Software without restriction,
+# including without limitation the rights to use, copy, modify, merge,
+# publish, distribute, sublicense, and/or sell copies of the Software,
+# and to permit persons to whom the Software is furnished to do so,
+# subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be
+# included in all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+# EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+# NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+# LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+# OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+# WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+# This contains the layout arithmetic used by MultiBox and Grid. The
+# children are still rendered and asked for their placement in Python,
+# but the measurement, line breaking, and placement is done on C arrays
+# of child sizes and positions.
+
+from __future__ import print_function
+
+from libc.stdlib cimport malloc, free
+from libc.math cimport floor
+
+import renpy
+from renpy.display.render cimport Render, render
+from renpy.display.core import absolute
+from renpy.display.displayable import Displayable
+
+# The default implementation of Displayable.place. Children that override
+# place are placed by calling their own method.
+base_place = Displayable.place
+
+
+cdef double compute_raw(object value, double room) except? -1:
+    """
+    The equivalent of absolute.compute_raw, for a position that may also
+    be None.
+    """
+
+    if value is None:
+        return 0
+    elif isinstance(value, (int, absolute)):
+        return value
+    elif isinstance(value, float):
+        return value * room
+
+    raise TypeError("Value {} of type {} not recognized as a position.".format(value, type(value)))
+
+
+cdef object place(Render dest, object child, double x, double y, double width, double height, Render surf):
+    """
+    Places `surf`, a render of `child`, into `dest`, within the area given
+    by `x`, `y`, `width`, and `height`. This is equivalent to
+    Displayable.place, and returns the (x, y) the render was blitted at.
+    """
+
+    if getattr(type(child), "place", base_place) is not base_place:
+        return child.place(dest, x, y, width, height, surf)
+
+    xpos, ypos, xanchor, yanchor, xoffset, yoffset, subpixel = child.get_placement()
+
+    # Offsets are always in pixels, even when they're floats.
+    if xoffset is None:
+        xoffset = 0
+    if yoffset is None:
+        yoffset = 0
+
+    x += compute_raw(xpos, width) + xoffset - compute_raw(xanchor, surf.width)
+    y += compute_raw(ypos, height) + yoffset - compute_raw(yanchor, surf.height)
+
+    pos = (x, y)
+
+    if subpixel:
+        dest.subpixel_blit(surf, pos, True, True, None)
+    else:
+        dest.blit(surf, pos, True, True, None)
+
+    return pos
+
+
+def grid_layout(list children, int cols, int rows, double renwidth, double renheight, bint xfill, bint yfill, double xspacing, double yspacing, double left_margin, double right_margin, double top_margin, double bottom_margin, double st, double at):
+    """
+    Renders and places the children of a grid. `children` is in row-major
+    order. Returns a (render, offsets) tuple, with offsets in the same order
+    as `children`.
+    """
+
+    cdef int n = cols * rows
+    cdef int i
+    cdef double cwidth = 0
+    cdef double cheight = 0
+    cdef double width, height
+    cdef Render surf
+    cdef Render rv
+    cdef list renders = [ ]
+    cdef list offsets = [ ]
+
+    for i in range(n):
+        surf = render(children[i], renwidth, renheight, st, at)
+        renders.append(surf)
+
+        if surf.width > cwidth:
+            cwidth = surf.width
+        if surf.height > cheight:
+            cheight = surf.height
+
+    if xfill:
+        cwidth = renwidth
+
+    if yfill:
+        cheight = renheight
+
+    width = cwidth * cols + xspacing * (cols - 1) + left_margin + right_margin
+    height = cheight * rows + yspacing * (rows - 1) + top_margin + bottom_margin
+
+    rv = Render(width, height)
+
+    for i in range(n):
+        offsets.append(place(
+            rv,
+            children[i],
+            (i % cols) * (cwidth + xspacing) + left_margin,
+            (i // cols) * (cheight + yspacing) + top_margin,
+            cwidth,
+            cheight,
+            renders[i]))
+
+    return rv, offsets
+
+
+cdef struct Line:
+
+    # The shared width and height of the line. The width is 0 for a
+    # horizontal box, and the height is 0 for a vertical box.
+    double width
+    double height
+
+    # The maximum x and y of all placed children.
+    double maxx
+    double maxy
+
+
+cdef void layout_line(Line *line, int start, int end, double xfill, double yfill, double *x, double *y, double *w, double *h, char *skip, bint box_skip):
+    """
+    Lays out the children from `start` to `end`, which have had x, y, w,
+    and h set to their position and size, distributing `xfill` and `yfill`
+    among them. This updates w and h to the size of the area each child is
+    placed in.
+    """
+
+    cdef int i
+    cdef int j = 0
+    cdef int count = 0
+    cdef double xperchild = 0
+    cdef double yperchild = 0
+
+    if xfill < 0:
+        xfill = 0
+    if yfill < 0:
+        yfill = 0
+
+    for i in range(start, end):
+        if not (box_skip and skip[i]):
+            count += 1
+
+    if count > 0:
+        xperchild = floor(xfill / count)
+        yperchild = floor(yfill / count)
+
+    for i in range(start, end):
+
+        if line.width > w[i]:
+            w[i] = line.width
+        if line.height > h[i]:
+            h[i] = line.height
+
+        if not (box_skip and skip[i]):
+            x[i] += j * xperchild
+            y[i] += j * yperchild
+
+            w[i] += xperchild
+            h[i] += yperchild
+
+            j += 1
+
+        if x[i] + w[i] > line.maxx:
+            line.maxx = x[i] + w[i]
+        if y[i] + h[i] > line.maxy:
+            line.maxy = y[i] + h[i]
+
+
+def box_layout(list children, list spacings, list csts, list cats, bint vertical, double width, double height, style):
+    """
+    Renders and places the children of a horizontal or vertical box.
+    `spacings`, `csts`, and `cats` give the spacing before, and times of,
+    each child. Returns a (render, offsets) tuple, with the offsets in the
+    same order as `children`.
+    """
+
+    cdef int n = len(children)
+    cdef int i, start
+    cdef Line line
+    cdef double cx = 0
+    cdef double cy = 0
+    cdef double sw, sh, padding, remaining, target, minx, miny
+    cdef double xminimum, yminimum, box_wrap_spacing
+    cdef bint box_skip = renpy.config.box_skip
+    cdef bint box_wrap = style.box_wrap
+    cdef bint xfill = style.xfill
+    cdef bint yfill = style.yfill
+    cdef bint simple_box_reverse = renpy.config.simple_box_reverse
+    cdef bint box_reverse = style.box_reverse
+    cdef bint order_reverse = style.order_reverse
+    cdef Render surf
+    cdef Render rv
+
+    cdef double *x
+    cdef double *y
+    cdef double *w
+    cdef double *h
+    cdef char *skip
+
+    # As in the Python MultiBox, the minimums are used as-is, in pixels.
+    xminimum = style.xminimum
+    yminimum = style.yminimum
+    box_wrap_spacing = style.box_wrap_spacing
+
+    if box_reverse and simple_box_reverse:
+        children = children[::-1]
+        spacings = spacings[::-1]
+
+    renders = [ ]
+    offsets = [ ]
+
+    line.width = 0
+    line.height = 0
+    line.maxx = 0
+    line.maxy = 0
+
+    x = <double *> malloc(sizeof(double) * n * 4 + 1)
+    y = x + n
+    w = y + n
+    h = w + n
+    skip = <char *> malloc(n + 1)
+
+    try:
+
+        for i in range(n):
+            skip[i] = children[i]._box_skip
+
+        start = 0
+
+        if vertical:
+
+            if xfill:
+                minx = width
+            else:
+                minx = xminimum
+
+            miny = 0
+
+            if yfill:
+                target = height
+            else:
+                target = yminimum
+
+            remaining = height
+
+            for i in range(n):
+
+                padding = spacings[i]
+
+                if box_skip and skip[i]:
+                    padding = 0
+
+                surf = render(children[i], width - cx, height if box_wrap else remaining, csts[i], cats[i])
+                renders.append(surf)
+
+                sw = surf.width
+                sh = surf.height
+
+                if box_wrap and remaining - sh - padding < 0:
+                    layout_line(&line, start, i, 0, target - cy, x, y, w, h, skip, box_skip)
+
+                    cx += line.width + box_wrap_spacing
+                    cy = 0
+                    line.width = 0
+                    remaining = height
+                    start = i
+
+                x[i] = cx
+                y[i] = cy
+                w[i] = sw
+                h[i] = sh
+
+                if sw > line.width:
+                    line.width = sw
+
+                cy += sh + padding
+                remaining -= sh + padding
+
+            layout_line(&line, start, n, 0, (target - cy) if not box_wrap else 0, x, y, w, h, skip, box_skip)
+
+        else:
+
+            if yfill:
+                miny = height
+            else:
+                miny = yminimum
+
+            minx = 0
+
+            if xfill:
+                target = width
+            else:
+                target = xminimum
+
+            remaining = width
+
+            for i in range(n):
+
+                padding = spacings[i]
+
+                if box_skip and skip[i]:
+                    padding = 0
+
+                surf = render(children[i], width if box_wrap else remaining, height - cy, csts[i], cats[i])
+                renders.append(surf)
+
+                sw = surf.width
+                sh = surf.height
+
+                if box_wrap and remaining - sw - padding < 0 and i > start:
+                    layout_line(&line, start, i, target - cx, 0, x, y, w, h, skip, box_skip)
+
+                    cy += line.height + box_wrap_spacing
+                    cx = 0
+                    line.height = 0
+                    remaining = width
+                    start = i
+
+                x[i] = cx
+                y[i] = cy
+                w[i] = sw
+                h[i] = sh
+
+                if sh > line.height:
+                    line.height = sh
+
+                cx += sw + padding
+                remaining -= sw + padding
+
+            layout_line(&line, start, n, (target - cx) if not box_wrap else 0, 0, x, y, w, h, skip, box_skip)
+
+        if not xfill:
+            width = max(xminimum, line.maxx)
+
+        if not yfill:
+            height = max(yminimum, line.maxy)
+
+        if box_reverse and not simple_box_reverse:
+            for i in range(n):
+                if vertical:
+                    y[i] = height - y[i] - h[i]
+                else:
+                    x[i] = width - x[i] - w[i]
+
+        rv = Render(width, height)
+
+        for i in (range(n - 1, -1, -1) if (order_reverse ^ (box_reverse and simple_box_reverse)) else range(n)):
+            offsets.append(place(rv, children[i], x[i], y[i], max(minx, w[i]), max(miny, h[i]), renders[i]))
+
+    finally:
+        free(x)
+        free(skip)
+
+    if order_reverse:
+        offsets.reverse()
+
+    return rv, offsets
@@ -27,6 +27,7 @@ from renpy.compat import PY2, basestring, bchr, bord, chr, open, pystr, range, r
 
 
 
+import io
 import sys
 import threading
 
@@ -138,6 +139,10 @@ copy_surface_unscaled = copy_surface
 # Formats we can load reentrantly.
 safe_formats = { "png", "jpg", "jpeg", "webp" }
 
+# Formats that renpy.display.imagedecode may be able to load, without
+# going through pygame_sdl2.
+native_formats = { "png", "jpg", "jpeg", "webp" }
+
 # Lock used for loading unsafe formats.
 image_load_lock = threading.RLock()
 
@@ -177,6 +182,22 @@ def load_image(f, filename, size=None):
 
     _basename, _dot, ext = filename.rpartition('.')
 
+    if renpy.config.native_image_decode and (size is None) and (ext.lower() in native_formats):
+
+        data = f.read()
+
+        try:
+            rv = renpy.display.imagedecode.decode(data, lambda size : surface_unscaled(size, True))
+        except Exception:
+            renpy.display.log.write("Native decoding of %r failed, falling back to SDL2_image:", filename)
+            renpy.display.log.exception()
+            rv = None
+
+        if rv is not None:
+            return rv
+
+        f = io.BytesIO(data)
+
     try:
 
         if ext.lower() in safe_formats:
@@ -95,8 +95,9 @@ cdef class Render:
     # Used to cache the model.
     cdef public object cached_model
 
-    # True if the texture has been loaded.
-    cdef public bint loaded
+    # If the textures have been loaded, the texture residency epoch they
+    # were loaded in. Otherwise, 0.
+    cdef public int loaded
 
     # A flag that's used to enable debugging on a per-render basis.
     cdef public bint debug
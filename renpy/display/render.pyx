@@ -703,8 +703,8 @@ cdef class Render:
         # Used to cache the model.
         self.cached_model = None
 
-        # Have the textures been loaded?
-        self.loaded = False
+        # Have the textures been loaded, and in which residency epoch?
+        self.loaded = 0
 
         live_renders.append(self)
 
@@ -744,7 +744,7 @@ cdef class Render:
         properties: dict
         cached_texture: Any
         cached_model: Any
-        loaded: bool
+        loaded: int
         """
 
     def __repr__(self): #@DuplicatedSignature
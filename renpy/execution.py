@@ -881,6 +881,10 @@ class Context(renpy.object.Object):
 
             yield True
 
+        # Predict the assets lookahead analysis found further ahead.
+        for _i in renpy.lookahead.predict(self.current):
+            yield True
+
         yield False
 
     def seen_current(self, ever):
@@ -2075,6 +2075,48 @@ def screenshot(filename):
     return renpy.game.interface.save_screenshot(filename)
 
 
+def start_capture(filename, fps=60, fixed=False, size=None):
+    """
+    :doc: other
+
+    Starts capturing the game, including the audio, to a video file. The
+    frames are read back from the GPU asynchronously and encoded on
+    background threads, so the game can keep running at full speed. This
+    requires the gl2 renderer.
+
+    `filename`
+        The file to capture to. The container and codecs are chosen
+        based on the extension, for example ".mp4" or ".webm".
+
+    `fps`
+        The number of frames per second of the video.
+
+    `fixed`
+        If true, the game runs with a fixed timestep of 1/`fps` seconds per
+        frame drawn, and audio is mixed for each frame rather than played.
+        This gives a frame-perfect capture, even when the game can't draw
+        frames in real time, but the game may run slower or faster than
+        real time while capturing.
+
+    `size`
+        If not None, a (width, height) tuple giving the size of the video.
+        If None, the video is the size of the drawable area of the window.
+    """
+
+    renpy.display.capture.start(filename, fps=fps, fixed=fixed, size=size)
+
+
+def stop_capture():
+    """
+    :doc: other
+
+    Stops capturing the game started with :func:`renpy.start_capture`, and
+    waits for the video file to be written.
+    """
+
+    renpy.display.capture.stop()
+
+
 def screenshot_to_bytes(size):
     """
     :doc: other
@@ -4249,6 +4291,77 @@ def get_texture_size():
     return renpy.display.draw.get_texture_size()
 
 
+def get_gl_profile():
+    """
+    :doc: debug
+
+    If :var:`config.gl_profile` is true and the gl2 renderer is in use,
+    returns a dictionary describing the last frame drawn. Otherwise,
+    returns None. The dictionary has the following keys:
+
+    ``"frame"``
+        The number of the frame.
+
+    ``"gpu_ms"``
+        The time the GPU took to draw the frame, in milliseconds, or None
+        if the GPU doesn't support timer queries.
+
+    ``"counts"``
+        A dictionary giving the number of draw calls, vertices, shader
+        program changes, framebuffer changes, texture uploads, bytes of
+        texture uploaded, and render-to-texture passes in the frame.
+
+    ``"groups"``
+        A list of dictionaries, one for each combination of displayable
+        and shaders that was drawn, slowest first. Each has the keys
+        "kind" (either "draw" or "rtt", for render-to-texture passes),
+        "displayable", "shaders", "draws", "vertices", and "gpu_ms".
+    """
+
+    get_gl_profile = getattr(renpy.display.draw, "get_gl_profile", None)
+
+    if get_gl_profile is None:
+        return None
+
+    return get_gl_profile()
+
+
+def get_rtt_stats():
+    """
+    :undocumented:
+
+    Returns a dictionary of statistics about the pool of textures that
+    renders are drawn into, or None if the renderer doesn't pool them.
+    The dictionary has the keys "hits", "misses", "pooled", "pool_size",
+    and "peak_texture_size", with the sizes in bytes.
+    """
+
+    get_rtt_stats = getattr(renpy.display.draw, "get_rtt_stats", None)
+
+    if get_rtt_stats is None:
+        return None
+
+    return get_rtt_stats()
+
+
+def get_texture_residency_stats():
+    """
+    :undocumented:
+
+    Returns a dictionary of statistics about the textures resident in
+    video memory, or None if the renderer doesn't track them. The
+    dictionary has the keys "budget", "resident_size", "evictable",
+    "evictions", and "reloads", with the sizes in bytes.
+    """
+
+    get_residency_stats = getattr(renpy.display.draw, "get_residency_stats", None)
+
+    if get_residency_stats is None:
+        return None
+
+    return get_residency_stats()
+
+
 old_battery = False
 
 
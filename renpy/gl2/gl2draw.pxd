@@ -65,6 +65,12 @@ cdef class GL2Draw:
 
     cdef public int fast_redraw_frames
 
+    # The number of frames that have been flipped.
+    cdef public int frame_number
+
+    # The readbacks that have not completed.
+    cdef list readbacks
+
     # The color texture object used for offscreen rendering.
     cdef GLuint color_renderbuffer
 
@@ -92,4 +98,23 @@ cdef class GL2Draw:
     # The current FBO.
     cdef public GLuint current_fbo
 
+    # True if timer queries can be used to measure GPU time.
+    cdef public bint timer_queries
+
+    # If config.gl_profile is true, the GPUProfile that records the
+    # current frame. Otherwise, None.
+    cdef public object profile
+
     cdef void change_fbo(self, GLuint fbo)
+
+
+cdef class Readback:
+
+    # The pixel buffer object the framebuffer is read into.
+    cdef GLuint pbo
+
+    cdef int width
+    cdef int height
+    cdef public int frame
+    cdef public object callback
+    cdef public bint cancelled
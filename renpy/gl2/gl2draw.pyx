@@ -26,6 +26,8 @@ from __future__ import print_function
 DEF ANGLE = False
 
 from libc.stdlib cimport malloc, free
+from libc.string cimport memcpy
+from libc.math cimport hypot
 from sdl2 cimport *
 from renpy.uguu.gl cimport *
 import renpy.gl2.gl2functions
@@ -79,6 +81,12 @@ frame_times = [ ]
 # The default position of the window.
 default_position = (pygame.WINDOWPOS_CENTERED, pygame.WINDOWPOS_CENTERED)
 
+# From GL_ARB_timer_query, which uguu doesn't define.
+cdef GLenum TIME_ELAPSED = 0x88BF
+
+# The functions required to use timer queries.
+TIMER_QUERY_FUNCTIONS = { "glGenQueries", "glDeleteQueries", "glBeginQuery", "glEndQuery", "glGetQueryObjectuiv" }
+
 cdef class GL2Draw:
 
     def __init__(self, name):
@@ -127,6 +135,12 @@ cdef class GL2Draw:
         # Has the position of this window ever been set?
         self.ever_set_position = False
 
+        # The number of frames that have been flipped to the screen.
+        self.frame_number = 0
+
+        # A list of Readbacks that have not completed yet.
+        self.readbacks = [ ]
+
     def get_texture_size(self):
         """
         Returns the amount of memory locked up in textures.
@@ -137,6 +151,39 @@ cdef class GL2Draw:
 
         return self.texture_loader.get_texture_size()
 
+    def get_gl_profile(self):
+        """
+        Returns the profile of the last frame drawn, or None if
+        config.gl_profile is false.
+        """
+
+        if self.profile is None:
+            return None
+
+        return self.profile.last_frame
+
+    def get_rtt_stats(self):
+        """
+        Returns a dictionary of statistics about the render-to-texture
+        pool, or None if there isn't one.
+        """
+
+        if self.texture_loader is None:
+            return None
+
+        return self.texture_loader.get_rtt_stats()
+
+    def get_residency_stats(self):
+        """
+        Returns a dictionary of statistics about the textures that are
+        resident in video memory, or None if there isn't a texture loader.
+        """
+
+        if self.texture_loader is None:
+            return None
+
+        return self.texture_loader.get_residency_stats()
+
     def select_physical_size(self, physical_size):
         """
         *Internal* Determines the 'best' physical size to use, and returns
@@ -435,6 +482,17 @@ cdef class GL2Draw:
         # Initialize the texture loader.
         self.texture_loader = TextureLoader(self)
 
+        # Can we time how long the GPU takes to draw?
+        self.timer_queries = (
+            (not self.gles)
+            and ("GL_ARB_timer_query" in extensions)
+            and (TIMER_QUERY_FUNCTIONS <= uguugl.found_functions))
+
+        self.profile = None
+
+        # Can we read back the framebuffer asynchronously?
+        self.info["readback"] = self.can_readback_async()
+
         self.on_resize(first=True)
 
         return True
@@ -442,6 +500,7 @@ cdef class GL2Draw:
     def on_resize(self, first=False):
 
         if not first:
+            self.finish_readbacks(True)
             self.quit_fbo()
             self.shader_cache.clear()
 
@@ -536,7 +595,9 @@ cdef class GL2Draw:
 
         self.draw_transform = Matrix.cscreen_projection(self.drawable_viewport[2], self.drawable_viewport[3])
 
-        self.shader_cache.load()
+        with renpy.startupprofile.phase("Load shader cache"):
+            self.shader_cache.load()
+
         self.init_fbo()
         self.texture_loader.init()
 
@@ -608,8 +669,13 @@ cdef class GL2Draw:
         if not fullscreen and not maximized:
             default_position = pygame.display.get_position()
 
+        self.finish_readbacks(True)
         self.kill_textures()
 
+        if self.profile is not None:
+            self.profile.quit()
+            self.profile = None
+
         if self.texture_loader is not None:
             self.texture_loader.quit()
             self.texture_loader = None
@@ -629,6 +695,9 @@ cdef class GL2Draw:
             glBindFramebuffer(GL_FRAMEBUFFER, fbo)
             self.current_fbo = fbo
 
+            if self.profile is not None:
+                self.profile.count("fbo_changes")
+
 
 
     def init_fbo(GL2Draw self):
@@ -867,6 +936,11 @@ cdef class GL2Draw:
 
         end = time.time()
 
+        self.frame_number += 1
+
+        if self.readbacks:
+            self.finish_readbacks(False)
+
         if vsync:
 
             # When the window is covered, we can get into a state where no
@@ -899,6 +973,16 @@ cdef class GL2Draw:
         if surf is None:
             return
 
+        if renpy.config.gl_profile:
+            if self.profile is None:
+                self.profile = GPUProfile(self.timer_queries)
+
+            self.profile.begin_frame()
+
+        elif self.profile is not None:
+            self.profile.quit()
+            self.profile = None
+
         # Load all the textures and RTTs.
         self.load_all_textures(surf)
 
@@ -927,9 +1011,19 @@ cdef class GL2Draw:
         context.draw(surf, transform)
 
         if flip:
+
+            if renpy.display.capture.capturing:
+                renpy.display.capture.before_flip(self)
+
             self.flip()
             self.texture_loader.cleanup()
 
+            if self.profile is not None:
+                self.profile.end_frame(self.frame_number)
+
+            if renpy.display.capture.capturing:
+                renpy.display.capture.after_flip()
+
     def load_all_textures(self, what):
         """
         This loads all textures from the surface tree before drawing to
@@ -950,10 +1044,18 @@ cdef class GL2Draw:
 
         cdef Render r = what
 
-        if r.loaded:
+        # When textures are evicted, the epoch changes, so Renders that
+        # might contain them are walked again to reload them.
+        if r.loaded == self.texture_loader.residency_epoch:
             return
 
-        r.loaded = True
+        r.loaded = self.texture_loader.residency_epoch
+
+        # The children have already been rendered to textures, which aren't
+        # evicted, so only the uniforms need to be reloaded.
+        if r.cached_model is not None:
+            r.cached_model.load()
+            return
 
         # Load the child textures.
         for i in r.children:
@@ -1108,61 +1210,204 @@ cdef class GL2Draw:
         x, y = self.untranslate_point(x, y)
         pygame.mouse.set_pos([x, y])
 
-    def screenshot(self, render_tree):
-        cdef unsigned char *pixels
-        cdef SDL_Surface *surf
+    def can_readback_async(self):
+        """
+        Returns True if the framebuffer can be read back asynchronously,
+        using a pixel buffer object.
+        """
 
-        cdef unsigned char *raw_pixels
-        cdef unsigned char *rpp
-        cdef int x, y, pitch
+        if renpy.emscripten:
+            return False
 
-        # A surface the size of the framebuffer.
-        full = renpy.display.pgrender.surface_unscaled(self.drawable_size, False)
-        surf = PySurface_AsSurface(full)
+        for i in [ "glGenBuffers", "glBindBuffer", "glBufferData", "glMapBufferRange", "glUnmapBuffer", "glDeleteBuffers" ]:
+            if i not in uguugl.found_functions:
+                return False
 
-        # Create an array that can hold densely-packed pixels.
-        raw_pixels = <unsigned char *> malloc(surf.w * surf.h * 4)
+        return True
+
+    def can_blit_downscale(self):
+        """
+        Returns True if the framebuffer can be downscaled on the GPU
+        before being read back.
+        """
+
+        cdef GLint samples = 0
+
+        if "glBlitFramebuffer" not in uguugl.found_functions:
+            return False
+
+        # Scaling blits from a multisampled framebuffer aren't allowed.
+        self.change_fbo(self.default_fbo)
+        glGetIntegerv(GL_SAMPLES, &samples)
+
+        return samples == 0
+
+    def prepare_readback(self, size):
+        """
+        *Internal*
+        Selects the framebuffer to read from, and returns the (x, y, w, h)
+        rectangle of it, in OpenGL coordinates, that contains the virtual
+        screen. If `size` is not None, the screen is downscaled on the GPU
+        to `size` first, so less data needs to be read back.
+        """
+
+        px, py, pw, ph = self.physical_box
+        xmul = 1.0 * self.drawable_size[0] / self.physical_size[0]
+        ymul = 1.0 * self.drawable_size[1] / self.physical_size[1]
+
+        cdef int x = int(px * xmul)
+        cdef int w = int(pw * xmul)
+        cdef int h = int(ph * ymul)
+
+        # OpenGL places the origin at the bottom of the framebuffer.
+        cdef int y = self.drawable_size[1] - int(py * ymul) - h
+
+        cdef int tw, th, nw, nh, dx
+        cdef GLuint src_fbo = self.default_fbo
+
+        self.change_fbo(self.default_fbo)
+
+        if size is None or not self.can_blit_downscale():
+            return x, y, w, h
+
+        tw, th = size
+        tw = max(tw, 1)
+        th = max(th, 1)
+
+        if tw >= w or th >= h:
+            return x, y, w, h
+
+        # A bilinear blit only samples a 2x2 block of pixels, so halve the
+        # image until it's within a factor of two of the target size. Each
+        # step is written next to its source in the offscreen fbo, so the
+        # two never overlap.
+        while True:
+
+            if (w > tw * 2) and (h > th * 2):
+                nw = w // 2
+                nh = h // 2
+            else:
+                nw = tw
+                nh = th
+
+            if (src_fbo == self.default_fbo) or (x > 0):
+                dx = 0
+            else:
+                dx = w
+
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, src_fbo)
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, self.fbo)
+            glBlitFramebuffer(x, y, x + w, y + h, dx, 0, dx + nw, nh, GL_COLOR_BUFFER_BIT, GL_LINEAR)
+
+            src_fbo = self.fbo
+            x, y, w, h = dx, 0, nw, nh
+
+            if (w == tw) and (h == th):
+                break
+
+        glBindFramebuffer(GL_FRAMEBUFFER, self.fbo)
+        self.current_fbo = self.fbo
+
+        return x, y, w, h
+
+    def screenshot(self, render_tree, size=None):
+        """
+        Draws `render_tree` and reads it back into a surface. If `size` is
+        given, the screen may be downscaled on the GPU to that size before
+        being read back.
+        """
+
+        cdef SDL_Surface *surf
+        cdef unsigned char *raw_pixels
 
         # Draw the last screen to the back buffer.
         if render_tree is not None:
             self.draw_screen(render_tree, flip=False)
-            glFinish()
-
-        # Read the pixels.
-        glReadPixels(
-            0,
-            0,
-            surf.w,
-            surf.h,
-            GL_RGBA,
-            GL_UNSIGNED_BYTE,
-            raw_pixels)
-
-        # Copy the pixels from raw_pixels to the surface.
-        pixels = <unsigned char *> surf.pixels
-        pitch = surf.pitch
-        rpp = raw_pixels
-
-        with nogil:
-            for y from 0 <= y < surf.h:
-                for x from 0 <= x < (surf.w * 4):
-                    pixels[x] = rpp[x]
-
-                pixels += pitch
-                rpp += surf.w * 4
 
-        free(raw_pixels)
+        x, y, w, h = self.prepare_readback(size)
 
-        px, py, pw, ph = self.physical_box
-        xmul = self.drawable_size[0] / self.physical_size[0]
-        ymul = self.drawable_size[1] / self.physical_size[1]
+        rv = renpy.display.pgrender.surface_unscaled((w, h), False)
+        surf = PySurface_AsSurface(rv)
+
+        # Create an array that can hold densely-packed pixels.
+        raw_pixels = <unsigned char *> malloc(w * h * 4)
 
-        # Crop and flip it, since it's upside down.
-        rv = full.subsurface((px * xmul, py * ymul, pw * xmul, ph * ymul))
-        rv = renpy.display.pgrender.flip_unscaled(rv, False, True)
+        glReadPixels(x, y, w, h, GL_RGBA, GL_UNSIGNED_BYTE, raw_pixels)
+
+        # Copy the pixels to the surface, flipping them, since they're
+        # upside down.
+        copy_flipped(raw_pixels, surf)
+
+        free(raw_pixels)
+
+        self.change_fbo(self.default_fbo)
 
         return rv
 
+    def screenshot_async(self, render_tree, size, callback):
+        """
+        Draws `render_tree` and starts reading it back into a pixel buffer
+        object. When the readback completes, a frame or two later,
+        `callback` is called with the surface, which may have been
+        downscaled on the GPU to `size`.
+
+        Returns a Readback object, or None if the readback had to be done
+        synchronously, in which case `callback` has already been called.
+        """
+
+        if not self.info.get("readback", False):
+            callback(self.screenshot(render_tree, size))
+            return None
+
+        if render_tree is not None:
+            self.draw_screen(render_tree, flip=False)
+
+        x, y, w, h = self.prepare_readback(size)
+
+        cdef Readback rb = Readback(w, h, self.frame_number, callback)
+
+        glGenBuffers(1, &rb.pbo)
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, rb.pbo)
+        glBufferData(GL_PIXEL_PACK_BUFFER, w * h * 4, NULL, GL_STREAM_READ)
+
+        # With a pack buffer bound, this queues a copy into the buffer
+        # rather than waiting for the GPU.
+        glReadPixels(x, y, w, h, GL_RGBA, GL_UNSIGNED_BYTE, NULL)
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0)
+
+        self.change_fbo(self.default_fbo)
+
+        self.readbacks.append(rb)
+
+        return rb
+
+    def finish_readbacks(self, force):
+        """
+        Completes the readbacks that were started at least
+        config.gl2_readback_frames frames ago, or all of them if `force`
+        is true.
+        """
+
+        cdef Readback rb
+
+        pending = [ ]
+        done = [ ]
+
+        for rb in self.readbacks:
+            if force or rb.cancelled or (self.frame_number - rb.frame >= renpy.config.gl2_readback_frames):
+                done.append(rb)
+            else:
+                pending.append(rb)
+
+        self.readbacks = pending
+
+        for rb in done:
+            surf = rb.finish()
+
+            if surf is not None:
+                rb.callback(surf)
+
     def kill_textures(self):
         if self.texture_loader is not None:
             self.texture_loader.cleanup()
@@ -1179,6 +1424,83 @@ cdef class GL2Draw:
         return (x, y)
 
 
+cdef void copy_flipped(unsigned char *src, SDL_Surface *surf) nogil:
+    """
+    Copies densely-packed RGBA pixels, as returned by glReadPixels, into
+    `surf`, flipping the rows.
+    """
+
+    cdef int y
+    cdef int row = surf.w * 4
+    cdef unsigned char *dst = <unsigned char *> surf.pixels
+
+    for y in range(surf.h):
+        memcpy(dst + (surf.h - 1 - y) * surf.pitch, src + y * row, row)
+
+
+cdef class Readback:
+    """
+    An asynchronous read of the framebuffer into a pixel buffer object.
+    """
+
+    def __init__(self, int width, int height, int frame, callback):
+
+        self.pbo = 0
+        self.width = width
+        self.height = height
+
+        # The frame number the readback was started on.
+        self.frame = frame
+
+        # Called with the surface when the readback finishes.
+        self.callback = callback
+
+        # True if the result isn't wanted anymore.
+        self.cancelled = False
+
+    def cancel(self):
+        """
+        Indicates the result of this readback is no longer needed.
+        """
+
+        self.cancelled = True
+
+    def finish(self):
+        """
+        Maps the pixel buffer, and copies it into a new surface. Returns
+        the surface, or None if the readback was cancelled or failed.
+        """
+
+        cdef SDL_Surface *surf
+        cdef unsigned char *pixels
+
+        if not self.pbo:
+            return None
+
+        rv = None
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, self.pbo)
+
+        if not self.cancelled:
+
+            pixels = <unsigned char *> glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, self.width * self.height * 4, GL_MAP_READ_BIT)
+
+            if pixels != NULL:
+                rv = renpy.display.pgrender.surface_unscaled((self.width, self.height), False)
+                surf = PySurface_AsSurface(rv)
+
+                with nogil:
+                    copy_flipped(pixels, surf)
+
+                glUnmapBuffer(GL_PIXEL_PACK_BUFFER)
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0)
+        glDeleteBuffers(1, &self.pbo)
+        self.pbo = 0
+
+        return rv
+
+
 cdef class GL2DrawingContext:
     """
     This is an object that represents the state of the GL rendering
@@ -1197,6 +1519,13 @@ cdef class GL2DrawingContext:
 
     cdef bint debug
 
+    # The GPUProfile of the draw, or None if profiling is off.
+    cdef object profile
+
+    # When profiling, the displayable the innermost Render being drawn
+    # is a render of.
+    cdef object displayable
+
     def __init__(self, GL2Draw draw, width, height, debug=False):
         self.gl2draw = draw
 
@@ -1205,6 +1534,9 @@ cdef class GL2DrawingContext:
 
         self.debug = debug
 
+        self.profile = draw.profile
+        self.displayable = None
+
     def merge_properties(self, dict old, dict child):
         """
         Merges the child properties into the old properties,
@@ -1251,6 +1583,49 @@ cdef class GL2DrawingContext:
 
         return Matrix.coffset(xoff / halfwidth, yoff / halfheight, 0) * transform
 
+    cdef void touch_textures(self, GL2Model model, Matrix transform, dict uniforms):
+        """
+        Called with the textures `model` is drawn with. This records the
+        frame they were last drawn in, for the texture budget, and generates
+        their deferred mipmaps if `transform` draws them smaller than their
+        resolution.
+        """
+
+        cdef float xscale, yscale
+        cdef gl2texture.GLTexture tex
+        cdef gl2texture.TextureLoader loader = self.gl2draw.texture_loader
+
+        # The number of drawable pixels per unit of the model. Under a
+        # perspective transform, assume part of the model is minified.
+        if transform.wdx or transform.wdy or transform.wdz:
+            xscale = 0
+            yscale = 0
+        else:
+            xscale = hypot(transform.xdx * self.width / 2, transform.ydx * self.height / 2)
+            yscale = hypot(transform.xdy * self.width / 2, transform.ydy * self.height / 2)
+
+        textures = [ ]
+
+        if isinstance(model, gl2texture.GLTexture):
+            textures.append(model)
+
+        for d in (model.uniforms, uniforms):
+            if d:
+                for v in d.values():
+                    if isinstance(v, gl2texture.GLTexture):
+                        textures.append(v)
+
+        for tex in textures:
+
+            tex.last_frame = loader.frame
+
+            if not tex.mipmap_pending:
+                continue
+
+            # Allow for a little rounding error when drawn at 1:1.
+            if (xscale * tex.width < tex.texture_width * .99) or (yscale * tex.height < tex.texture_height * .99):
+                tex.generate_mipmaps()
+
     def draw_model(self, model, Matrix transform, Polygon clip_polygon, tuple shaders, dict uniforms, dict properties):
 
         cdef Mesh mesh = model.mesh
@@ -1273,8 +1648,14 @@ cdef class GL2DrawingContext:
             import renpy.gl2.gl2debug as gl2debug
             gl2debug.geometry(mesh, transform, self.width, self.height)
 
+        if self.gl2draw.texture_loader.mipmaps_pending > 0 or self.gl2draw.texture_loader.track_residency:
+            self.touch_textures(model, transform, uniforms)
+
         program = self.gl2draw.shader_cache.get(shaders)
 
+        if self.profile is not None:
+            query = self.profile.begin_timer()
+
         program.start()
 
         program.set_uniform("u_model_size", (model.width, model.height))
@@ -1288,6 +1669,9 @@ cdef class GL2DrawingContext:
         program.draw(mesh, properties)
         program.finish()
 
+        if self.profile is not None:
+            self.profile.end_draw(query, self.displayable, shaders, program, mesh.points)
+
     def draw_one(self, what, Matrix transform, Polygon clip_polygon, tuple shaders, dict uniforms, dict properties):
         """
         This is responsible for walking the surface tree, and drawing any
@@ -1385,6 +1769,11 @@ cdef class GL2DrawingContext:
         if r.cached_model is not None:
             children = [ (r.cached_model, 0, 0, False, False) ]
 
+        old_displayable = self.displayable
+
+        if (self.profile is not None) and r.render_of:
+            self.displayable = r.render_of[0]
+
         for child, cx, cy, focus, main in children:
 
             child_transform = transform
@@ -1409,6 +1798,7 @@ cdef class GL2DrawingContext:
 
             self.draw_one(child, child_transform, child_clip_polygon, shaders, uniforms, child_properties)
 
+        self.displayable = old_displayable
 
         if depth:
             glDisable(GL_DEPTH_TEST)
@@ -1429,6 +1819,246 @@ cdef class GL2DrawingContext:
         self.draw_one(what, transform, clip_polygon, shaders, uniforms, properties)
 
 
+def describe(d):
+    """
+    Returns a short description of the displayable `d`, for the profile.
+    """
+
+    if d is None:
+        return "(none)"
+
+    rv = repr(d)
+
+    if len(rv) > 80:
+        rv = rv[:77] + "..."
+
+    return rv
+
+
+cdef class GPUProfile:
+    """
+    This records what is drawn in each frame when config.gl_profile is
+    true. It counts draw calls, state changes, texture uploads, and
+    render-to-texture passes, and groups the draws by the displayable and
+    shaders involved. If timer queries are available, it also measures
+    the GPU time taken by each draw and render-to-texture pass.
+    """
+
+    # Can timer queries be used?
+    cdef bint timer_queries
+
+    # Query objects that aren't in use.
+    cdef list free_queries
+
+    # A list of (query, group key) pairs for queries that have been issued
+    # this frame.
+    cdef list pending
+
+    # The query that's currently active, or 0 if none is. Timer queries
+    # can't nest, so draws inside a render-to-texture pass are counted,
+    # but timed as part of the pass.
+    cdef GLuint active_query
+
+    # The program used by the last draw.
+    cdef object last_program
+
+    # A map from counter name to value.
+    cdef dict counts
+
+    # A map from (kind, displayable description, shaders) to a list of
+    # [ draws, vertices, gpu nanoseconds ].
+    cdef dict groups
+
+    # The profile of the last frame, as returned by renpy.get_gl_profile.
+    cdef public object last_frame
+
+    def __init__(self, timer_queries):
+        self.timer_queries = timer_queries
+        self.free_queries = [ ]
+        self.pending = [ ]
+        self.active_query = 0
+        self.last_program = None
+        self.counts = { }
+        self.groups = { }
+        self.last_frame = None
+
+    def quit(self):
+        """
+        Deletes the query objects.
+        """
+
+        cdef GLuint query
+
+        self.collect()
+
+        for query in self.free_queries:
+            glDeleteQueries(1, &query)
+
+        self.free_queries = [ ]
+
+    def begin_frame(self):
+        """
+        Called at the start of drawing a frame. This discards anything
+        drawn since the last frame was flipped, like a screenshot.
+        """
+
+        self.collect()
+
+        self.last_program = None
+
+        self.counts = {
+            "draws" : 0,
+            "vertices" : 0,
+            "program_changes" : 0,
+            "fbo_changes" : 0,
+            "texture_uploads" : 0,
+            "texture_upload_bytes" : 0,
+            "rtt_passes" : 0,
+            }
+
+        self.groups = { }
+
+    def count(self, name, n=1):
+        self.counts[name] = self.counts.get(name, 0) + n
+
+    def begin_timer(self):
+        """
+        Starts timing the GPU, and returns the query to pass to the
+        corresponding end method, which is 0 if timing isn't possible.
+        """
+
+        cdef GLuint query
+
+        if (not self.timer_queries) or self.active_query:
+            return 0
+
+        if self.free_queries:
+            query = self.free_queries.pop()
+        else:
+            glGenQueries(1, &query)
+
+        glBeginQuery(TIME_ELAPSED, query)
+        self.active_query = query
+
+        return query
+
+    cdef void end_timer(self, GLuint query, tuple key):
+
+        if not query:
+            return
+
+        glEndQuery(TIME_ELAPSED)
+        self.active_query = 0
+
+        self.pending.append((query, key))
+
+    cdef list group(self, tuple key):
+
+        rv = self.groups.get(key, None)
+
+        if rv is None:
+            rv = self.groups[key] = [ 0, 0, 0 ]
+
+        return rv
+
+    def end_draw(self, query, displayable, shaders, program, vertices):
+        """
+        Called after a model has been drawn.
+        """
+
+        key = ("draw", describe(displayable), shaders)
+
+        self.end_timer(query, key)
+
+        g = self.group(key)
+        g[0] += 1
+        g[1] += vertices
+
+        self.counts["draws"] += 1
+        self.counts["vertices"] += vertices
+
+        if program is not self.last_program:
+            self.counts["program_changes"] += 1
+            self.last_program = program
+
+    def end_rtt(self, query, what):
+        """
+        Called after `what`, a Render, has been rendered to a texture.
+        """
+
+        render_of = getattr(what, "render_of", None)
+        key = ("rtt", describe(render_of[0] if render_of else None), ())
+
+        self.end_timer(query, key)
+
+        g = self.group(key)
+        g[0] += 1
+
+        self.counts["rtt_passes"] += 1
+
+        # The next draw to the screen needs a program change.
+        self.last_program = None
+
+    def collect(self):
+        """
+        Waits for the pending queries to finish, and adds their times to
+        the groups. Returns the total GPU time, in nanoseconds.
+        """
+
+        cdef GLuint query
+        cdef GLuint ns
+        cdef unsigned long long total = 0
+
+        for query, key in self.pending:
+            ns = 0
+            glGetQueryObjectuiv(query, GL_QUERY_RESULT, &ns)
+            self.free_queries.append(query)
+
+            g = self.groups.get(key, None)
+
+            if g is not None:
+                g[2] += ns
+
+            total += ns
+
+        self.pending = [ ]
+
+        return total
+
+    def end_frame(self, frame):
+        """
+        Called after the frame has been flipped, to produce its profile.
+        """
+
+        gpu_ns = self.collect()
+
+        groups = [ ]
+
+        for (kind, displayable, shaders), (draws, vertices, ns) in self.groups.items():
+            groups.append({
+                "kind" : kind,
+                "displayable" : displayable,
+                "shaders" : shaders,
+                "draws" : draws,
+                "vertices" : vertices,
+                "gpu_ms" : (ns / 1000000.0) if self.timer_queries else None,
+                })
+
+        if self.timer_queries:
+            groups.sort(key=lambda g : (-g["gpu_ms"], -g["draws"]))
+        else:
+            groups.sort(key=lambda g : -g["draws"])
+
+        self.last_frame = {
+            "frame" : frame,
+            "gpu_ms" : (gpu_ns / 1000000.0) if self.timer_queries else None,
+            "counts" : dict(self.counts),
+            "groups" : groups,
+            }
+
+        self.groups = { }
+
+
 # A set of uniforms that are defined by Ren'Py, and shouldn't be set in ATL.
 standard_uniforms = { "u_transform", "u_time", "u_random" }
 
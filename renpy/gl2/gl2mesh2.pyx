@@ -160,6 +160,67 @@ cdef class Mesh2(Mesh):
         return rv
 
 
+    @staticmethod
+    def texture_rectangles(list rectangles):
+        """
+        Creates a mesh consisting of multiple, independent, texture
+        rectangles. `rectangles` is a list of (pl, pb, pr, pt, tl, tb, tr, tt)
+        tuples, with the same meaning as the arguments to texture_rectangle.
+        """
+
+        cdef int count = len(rectangles)
+        cdef Mesh2 rv = Mesh2(TEXTURE_LAYOUT, count * 4, count * 2)
+
+        cdef int i
+        cdef int p
+        cdef int t
+        cdef double pl, pb, pr, pt, tl, tb, tr, tt
+
+        for 0 <= i < count:
+
+            pl, pb, pr, pt, tl, tb, tr, tt = rectangles[i]
+
+            p = i * 4
+
+            rv.point[p + 0].x = pl
+            rv.point[p + 0].y = pb
+
+            rv.point[p + 1].x = pr
+            rv.point[p + 1].y = pb
+
+            rv.point[p + 2].x = pr
+            rv.point[p + 2].y = pt
+
+            rv.point[p + 3].x = pl
+            rv.point[p + 3].y = pt
+
+            rv.attribute[p * 2 + 0] = tl
+            rv.attribute[p * 2 + 1] = tb
+
+            rv.attribute[p * 2 + 2] = tr
+            rv.attribute[p * 2 + 3] = tb
+
+            rv.attribute[p * 2 + 4] = tr
+            rv.attribute[p * 2 + 5] = tt
+
+            rv.attribute[p * 2 + 6] = tl
+            rv.attribute[p * 2 + 7] = tt
+
+            t = i * 6
+
+            rv.triangle[t + 0] = p + 0
+            rv.triangle[t + 1] = p + 1
+            rv.triangle[t + 2] = p + 2
+
+            rv.triangle[t + 3] = p + 0
+            rv.triangle[t + 4] = p + 2
+            rv.triangle[t + 5] = p + 3
+
+        rv.points = count * 4
+        rv.triangles = count * 2
+
+        return rv
+
     @staticmethod
     def texture_grid_mesh(
         int width, int height,
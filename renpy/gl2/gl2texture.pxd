@@ -51,6 +51,43 @@ cdef class TextureLoader:
 
     cdef GLfloat max_anisotropy
 
+    # A map from the key of a render-to-texture texture - its size and
+    # parameters - to a list of (number, frame) pairs, giving unused
+    # textures with that key, and the frame they were released in.
+    cdef dict rtt_pool
+
+    # A list of (number, key) pairs for render-to-texture textures that
+    # have been released this frame, and will be pooled at its end.
+    cdef list rtt_released
+
+    # The number of frames that have been cleaned up.
+    cdef int frame
+
+    # Statistics about the render-to-texture pool. The sizes are in bytes.
+    cdef public object rtt_hits
+    cdef public object rtt_misses
+    cdef public object rtt_pool_size
+    cdef public object peak_texture_size
+
+    # The number of loaded textures whose mipmaps haven't been generated
+    # yet, as they haven't been drawn minified.
+    cdef public int mipmaps_pending
+
+    # True if the frame each texture is drawn in should be tracked, as
+    # config.texture_budget is set.
+    cdef public bint track_residency
+
+    # The textures that can be evicted from video memory, as they can be
+    # reloaded.
+    cdef public object evictable
+
+    # Incremented each time textures are evicted. This starts at 1.
+    cdef public int residency_epoch
+
+    # The number of textures that have been evicted and reloaded.
+    cdef public object evictions
+    cdef public object reloads
+
 
 cdef class GLTexture(GL2Model):
 
@@ -73,4 +110,20 @@ cdef class GLTexture(GL2Model):
     cdef public int texture_width
     cdef public int texture_height
 
+    # If this texture was rendered to, the key it is pooled under when
+    # it's no longer used. Otherwise, None.
+    cdef object rtt_key
+
+    # True if this texture should have mipmaps, but they won't be
+    # generated until it's drawn minified.
+    cdef public bint mipmap_pending
+
+    # A function that returns the surface this texture was loaded from,
+    # used to reload it after it's been evicted, or None if the texture
+    # can't be evicted.
+    cdef object reload
+
+    # The number of the frame this texture was last drawn or loaded in.
+    cdef public int last_frame
+
     cpdef subsurface(GLTexture self, t)
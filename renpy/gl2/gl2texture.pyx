@@ -58,6 +58,20 @@ cdef GLenum MAX_TEXTURE_MAX_ANISOTROPY_EXT = 0x84FF
 
 ################################################################################
 
+def rtt_size(key):
+    """
+    Returns the number of bytes of memory used by a render-to-texture
+    texture with `key`.
+    """
+
+    tw, th, max_level = key[:3]
+
+    if max_level:
+        return int(tw * th * 4 * 1.34)
+    else:
+        return tw * th * 4
+
+
 cdef class TextureLoader:
 
     def __init__(TextureLoader self, GL2Draw draw):
@@ -67,6 +81,30 @@ cdef class TextureLoader:
         self.texture_load_queue = weakref.WeakSet()
         self.draw = draw
 
+        self.reset_rtt_pool()
+
+        self.evictable = weakref.WeakSet()
+        self.residency_epoch = 1
+        self.evictions = 0
+        self.reloads = 0
+
+    def reset_rtt_pool(self):
+        """
+        Empties the render-to-texture pool, and resets its statistics. This
+        doesn't free the pooled textures.
+        """
+
+        self.rtt_pool = { }
+        self.rtt_released = [ ]
+        self.frame = 0
+
+        self.rtt_hits = 0
+        self.rtt_misses = 0
+        self.rtt_pool_size = 0
+        self.peak_texture_size = 0
+
+        self.mipmaps_pending = 0
+
     def init(self):
 
         if self.allocated:
@@ -79,6 +117,13 @@ cdef class TextureLoader:
         self.total_texture_size = 0
         self.texture_load_queue = weakref.WeakSet()
 
+        self.reset_rtt_pool()
+
+        # Textures from a previous context aren't resident, so make sure
+        # every Render is walked to load them again.
+        self.evictable = weakref.WeakSet()
+        self.residency_epoch += 1
+
         if not self.draw.gles:
             glGetFloatv(MAX_TEXTURE_MAX_ANISOTROPY_EXT, &self.max_anisotropy)
 
@@ -94,6 +139,7 @@ cdef class TextureLoader:
             glDeleteTextures(1, texnums)
 
         self.allocated = set()
+        self.reset_rtt_pool()
 
     def get_texture_size(self):
         """
@@ -102,6 +148,75 @@ cdef class TextureLoader:
 
         return self.total_texture_size, len(self.allocated)
 
+    def update_peak_texture_size(self):
+        """
+        Called when a texture is allocated, to track the most memory that
+        has been used by textures, including pooled ones.
+        """
+
+        size = self.total_texture_size + self.rtt_pool_size
+
+        if size > self.peak_texture_size:
+            self.peak_texture_size = size
+
+    def get_residency_stats(self):
+        """
+        Returns a dictionary of statistics about texture residency.
+        """
+
+        return {
+            "budget" : renpy.config.texture_budget,
+            "resident_size" : self.total_texture_size,
+            "evictable" : len(self.evictable),
+            "evictions" : self.evictions,
+            "reloads" : self.reloads,
+            }
+
+    def enforce_texture_budget(self):
+        """
+        If the textures use more memory than config.texture_budget, evicts
+        the evictable textures that were drawn least recently, until they
+        don't. Textures drawn in this or the last frame aren't evicted.
+        """
+
+        budget = renpy.config.texture_budget
+
+        self.track_residency = budget is not None
+
+        if budget is None:
+            return
+
+        if self.total_texture_size <= budget:
+            return
+
+        candidates = [ i for i in self.evictable if i.loaded and (i.last_frame < self.frame - 1) ]
+        candidates.sort(key=lambda i : i.last_frame)
+
+        evicted = False
+
+        for tex in candidates:
+            if self.total_texture_size <= budget:
+                break
+
+            tex.evict()
+            evicted = True
+
+        if evicted:
+            self.residency_epoch += 1
+
+    def get_rtt_stats(self):
+        """
+        Returns a dictionary of statistics about the render-to-texture pool.
+        """
+
+        return {
+            "hits" : self.rtt_hits,
+            "misses" : self.rtt_misses,
+            "pooled" : sum(len(i) for i in self.rtt_pool.values()),
+            "pool_size" : self.rtt_pool_size,
+            "peak_texture_size" : self.peak_texture_size,
+            }
+
     def load_one_surface(self, surf, bl, bt, br, bb, properties):
         """
         Converts a surface into a texture.
@@ -206,6 +321,71 @@ cdef class TextureLoader:
         rv.from_render(what, properties)
         return rv
 
+    def take_rtt_texture(self, key):
+        """
+        Removes a texture with `key` from the render-to-texture pool, and
+        returns its number. Returns 0 if the pool has no such texture.
+        """
+
+        entries = self.rtt_pool.get(key, None)
+
+        if not entries:
+            self.rtt_misses += 1
+            return 0
+
+        number, _frame = entries.pop()
+
+        if not entries:
+            del self.rtt_pool[key]
+
+        self.rtt_pool_size -= rtt_size(key)
+        self.rtt_hits += 1
+
+        return number
+
+    def pool_rtt_textures(self):
+        """
+        Moves the render-to-texture textures released this frame into the
+        pool, and queues pooled textures that haven't been reused in
+        config.rtt_pool_frames frames, or that don't fit in the pool, to be
+        freed.
+        """
+
+        limit = renpy.config.rtt_pool_size
+        frames = renpy.config.rtt_pool_frames
+
+        for number, key in self.rtt_released:
+
+            # The texture belongs to a context that's been lost.
+            if number not in self.allocated:
+                continue
+
+            size = rtt_size(key)
+
+            if self.rtt_pool_size + size > limit:
+                self.free_list.append(number)
+                continue
+
+            self.rtt_pool.setdefault(key, [ ]).append((number, self.frame))
+            self.rtt_pool_size += size
+
+        self.rtt_released = [ ]
+
+        for key in list(self.rtt_pool):
+
+            keep = [ ]
+
+            for number, frame in self.rtt_pool[key]:
+                if self.frame - frame > frames:
+                    self.free_list.append(number)
+                    self.rtt_pool_size -= rtt_size(key)
+                else:
+                    keep.append((number, frame))
+
+            if keep:
+                self.rtt_pool[key] = keep
+            else:
+                del self.rtt_pool[key]
 
     def cleanup(self):
         """
@@ -214,6 +394,10 @@ cdef class TextureLoader:
 
         cdef GLuint texnums[1]
 
+        self.frame += 1
+        self.pool_rtt_textures()
+        self.enforce_texture_budget()
+
         for texture_number in self.free_list:
             texnums[0] = texture_number
             glDeleteTextures(1, texnums)
@@ -276,6 +460,16 @@ cdef class GLTexture(GL2Model):
         # Update the loader.
         self.loader = loader
 
+        # Set by from_render.
+        self.rtt_key = None
+
+        # Set when the texture is loaded from a surface.
+        self.mipmap_pending = False
+
+        # Set by set_reload.
+        self.reload = None
+        self.last_frame = 0
+
         if renpy.emscripten and generate:
             # Generate a texture name to access video frames for web
             glGenTextures(1, &number)
@@ -291,10 +485,55 @@ cdef class GLTexture(GL2Model):
     def has_mipmaps(GLTexture self):
         """
         Returns true if this texture has mipmaps (or will have mipmaps
-        when it's loaded).
+        when it's loaded). This is false while the generation of the
+        mipmaps is deferred.
+        """
+
+        return self.properties.get("mipmap", True) and not self.mipmap_pending
+
+    def defer_mipmaps(GLTexture self):
+        """
+        Called before a texture is loaded from a surface, to defer the
+        generation of its mipmaps until it's drawn minified.
+        """
+
+        if not renpy.config.lazy_mipmaps:
+            return
+
+        if not self.has_mipmaps():
+            return
+
+        self.mipmap_pending = True
+        self.loader.mipmaps_pending += 1
+
+    def generate_mipmaps(GLTexture self):
         """
+        Generates the mipmaps of this texture, if they were deferred. This
+        is called when the texture is drawn minified.
+        """
+
+        if not self.mipmap_pending:
+            return
+
+        self.mipmap_pending = False
+        self.loader.mipmaps_pending -= 1
+
+        if not self.loaded:
+            return
+
+        # Account for the memory used by the mipmaps.
+        self.loader.total_texture_size += int(self.width * self.height * 4 * 1.34) - int(self.width * self.height * 4)
+        self.loader.update_peak_texture_size()
+
+        glBindTexture(GL_TEXTURE_2D, self.number)
+
+        if renpy.config.max_mipmap_level:
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST)
 
-        return self.properties.get("mipmap", True)
+        self.mipmap_texture(self.number, self.texture_width, self.texture_height, self.properties)
+
+        if self.loader.draw.profile is not None:
+            self.loader.draw.profile.count("mipmaps_generated")
 
     def get_number(GLTexture self):
         return self.number if renpy.emscripten else None
@@ -361,7 +600,17 @@ cdef class GLTexture(GL2Model):
 
         cdef GLuint premultiplied
 
-        glGenTextures(1, &premultiplied)
+        # Textures with the same size and parameters are interchangeable, so
+        # reuse one from the pool if possible.
+        key = (
+            tw,
+            th,
+            renpy.config.max_mipmap_level if properties.get("mipmap", True) else 0,
+            tuple(properties.get("texture_wrap", (GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE))),
+            bool(properties.get("anisotropic", True)),
+            )
+
+        premultiplied = loader.take_rtt_texture(key)
 
         # Bind the framebuffer.
         draw.change_fbo(draw.fbo)
@@ -370,7 +619,11 @@ cdef class GLTexture(GL2Model):
         cdef Matrix transform
         transform = Matrix.ctexture_projection(cw, ch)
 
-        self.allocate_texture(premultiplied, tw, th, properties)
+        if premultiplied:
+            self.reuse_texture(premultiplied, tw, th)
+        else:
+            glGenTextures(1, &premultiplied)
+            self.allocate_texture(premultiplied, tw, th, properties)
 
         # Set up the viewport.
         glViewport(0, 0, tw, th)
@@ -383,17 +636,28 @@ cdef class GLTexture(GL2Model):
         glEnable(GL_BLEND)
         glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA)
 
+        profile = draw.profile
+
+        if profile is not None:
+            query = profile.begin_timer()
+
         context = renpy.gl2.gl2draw.GL2DrawingContext(draw, tw, th)
         context.draw(what, transform)
 
+        if profile is not None:
+            profile.end_rtt(query, what)
+
+        # The storage was allocated by allocate_texture, so copy into it
+        # rather than redefining it.
         glBindTexture(GL_TEXTURE_2D, premultiplied)
-        glCopyTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 0, 0, tw, th, 0)
+        glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, tw, th)
 
         self.mipmap_texture(premultiplied, tw, th, properties)
 
         self.number = premultiplied
         self.loader.allocated.add(self.number)
 
+        self.rtt_key = key
         self.loaded = True
 
 
@@ -419,6 +683,12 @@ cdef class GLTexture(GL2Model):
 
         s = PySurface_AsSurface(self.surface)
 
+        self.defer_mipmaps()
+
+        if draw.profile is not None:
+            draw.profile.count("texture_uploads")
+            draw.profile.count("texture_upload_bytes", s.h * s.pitch)
+
         # Generate the old textures.
         glGenTextures(1, &tex)
         glGenTextures(1, &premultiplied)
@@ -511,6 +781,12 @@ cdef class GLTexture(GL2Model):
 
         s = PySurface_AsSurface(self.surface)
 
+        self.defer_mipmaps()
+
+        if draw.profile is not None:
+            draw.profile.count("texture_uploads")
+            draw.profile.count("texture_upload_bytes", s.h * s.pitch)
+
         glGenTextures(1, &premultiplied)
 
         # Load the pixel data into tex, and set it up for drawing.
@@ -570,11 +846,13 @@ cdef class GLTexture(GL2Model):
         else:
             self.loader.total_texture_size += int(self.width * self.height * 4)
 
+        self.loader.update_peak_texture_size()
+
         glBindTexture(GL_TEXTURE_2D, tex)
 
         max_level = renpy.config.max_mipmap_level
 
-        if not properties.get("mipmap", True):
+        if (not properties.get("mipmap", True)) or self.mipmap_pending:
             max_level = 0
 
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, max_level)
@@ -614,6 +892,24 @@ cdef class GLTexture(GL2Model):
             if level > max_level:
                 break
 
+    def reuse_texture(GLTexture self, GLuint tex, int tw, int th):
+        """
+        Uses `tex`, a pooled `tw` x `th` texture that was allocated by
+        allocate_texture with the same parameters, to store this texture.
+        """
+
+        if self.has_mipmaps():
+            self.loader.total_texture_size += int(self.width * self.height * 4 * 1.34)
+        else:
+            self.loader.total_texture_size += int(self.width * self.height * 4)
+
+        self.loader.update_peak_texture_size()
+
+        glBindTexture(GL_TEXTURE_2D, tex)
+
+        self.texture_width = tw
+        self.texture_height = th
+
     def mipmap_texture(GLTexture self, GLuint tex, int tw, int th, properties={}):
         """
         Generate the mipmaps for a texture.
@@ -621,7 +917,7 @@ cdef class GLTexture(GL2Model):
 
         cdef GLuint level = renpy.config.max_mipmap_level
 
-        if not properties.get("mipmap", True):
+        if (not properties.get("mipmap", True)) or self.mipmap_pending:
             level = 0
 
         glBindTexture(GL_TEXTURE_2D, tex)
@@ -638,8 +934,14 @@ cdef class GLTexture(GL2Model):
 
     def __del__(self):
         try:
+            if self.mipmap_pending:
+                self.loader.mipmaps_pending -= 1
+
             if self.loaded:
-                self.loader.free_list.append(self.number)
+                if self.rtt_key is not None:
+                    self.loader.rtt_released.append((self.number, self.rtt_key))
+                else:
+                    self.loader.free_list.append(self.number)
 
                 if self.has_mipmaps():
                     self.loader.total_texture_size -= int(self.width * self.height * 4 * 1.34)
@@ -650,11 +952,81 @@ cdef class GLTexture(GL2Model):
 
     def load(self):
 
+        if self.loaded:
+            return
+
+        if (self.surface is None) and (self.reload is not None):
+            self.surface = self.reload()
+            self.loader.reloads += 1
+
         if self.properties.get("premultiplied", False):
             self.load_gltexture_premultiplied()
         else:
             self.load_gltexture()
 
+        self.last_frame = self.loader.frame
+
+        if self.reload is not None:
+            self.loader.evictable.add(self)
+
+    def set_reload(self, reload):
+        """
+        Makes this texture evictable. `reload` is a function that returns
+        the surface the texture was loaded from, that's called if the
+        texture needs to be loaded again after being evicted.
+        """
+
+        self.reload = reload
+
+        if self.loaded:
+            self.loader.evictable.add(self)
+
+    def evict(self):
+        """
+        Frees the video memory used by this texture. It will be reloaded
+        the next time it's needed.
+        """
+
+        if not self.loaded or self.reload is None:
+            return
+
+        self.loader.free_list.append(self.number)
+
+        if self.has_mipmaps():
+            self.loader.total_texture_size -= int(self.width * self.height * 4 * 1.34)
+        else:
+            self.loader.total_texture_size -= int(self.width * self.height * 4)
+
+        if self.mipmap_pending:
+            self.mipmap_pending = False
+            self.loader.mipmaps_pending -= 1
+
+        self.number = 0
+        self.loaded = False
+
+        self.loader.evictable.discard(self)
+        self.loader.evictions += 1
+
+    def restore(self):
+        """
+        If this texture has been evicted, reloads its surface, and queues
+        it to be loaded onto the GPU. This may be called from the image
+        prediction thread.
+        """
+
+        if self.loaded or self.reload is None or self.surface is not None:
+            return
+
+        surface = self.reload()
+
+        # The main thread may have loaded the texture while the surface was
+        # being reloaded, in which case the surface isn't needed.
+        if self.loaded or self.surface is not None:
+            return
+
+        self.surface = surface
+        self.loader.reloads += 1
+        self.loader.texture_load_queue.add(self)
 
 
     def program_uniforms(self, shader):
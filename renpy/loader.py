@@ -32,6 +32,8 @@ import threading
 import zlib
 import re
 import io
+import heapq
+import time
 import unicodedata
 
 from pygame_sdl2.rwobject import RWops_from_file, RWops_create_subfile
@@ -767,6 +769,10 @@ def load_from_remote_file(name):
 if renpy.emscripten or os.environ.get('RENPY_SIMULATE_DOWNLOAD', False):
     file_open_callbacks.append(load_from_remote_file)
 
+# The callbacks that Ren'Py itself adds to file_open_callbacks, which the
+# I/O scheduler knows how to locate files for.
+builtin_file_open_callbacks = list(file_open_callbacks)
+
 
 def check_name(name):
     """
@@ -813,7 +819,15 @@ def get_prefixes(tl=True, directory=None):
     return rv
 
 
-def load(name, directory=None, tl=True):
+def load(name, directory=None, tl=True, priority=None):
+    """
+    Returns an open file-like object for `name`.
+
+    `priority`
+        If not None, one of the IO_ priorities. The file is read in its
+        entirety through the I/O scheduler, and returned as a BytesIO, if
+        possible.
+    """
 
     if renpy.display.predict.predicting: # @UndefinedVariable
         if threading.current_thread().name == "MainThread":
@@ -825,6 +839,12 @@ def load(name, directory=None, tl=True):
 
     name = re.sub(r'/+', '/', name).lstrip('/')
 
+    if (priority is not None) and io_enabled():
+        data = scheduled_read(name, directory, tl, priority)
+
+        if data is not None:
+            return io.BytesIO(data)
+
     for p in get_prefixes(directory=directory, tl=tl):
         rv = load_core(p + name)
         if rv is not None:
@@ -833,6 +853,393 @@ def load(name, directory=None, tl=True):
     raise IOError("Couldn't find file '%s'." % name)
 
 
+################################################################################
+# I/O scheduler.
+################################################################################
+
+# The priorities of reads made through the I/O scheduler, most urgent first.
+IO_AUDIO = 0
+IO_IMAGE = 1
+IO_PREDICT = 2
+IO_BACKGROUND = 3
+
+IO_CLASS_NAMES = [ "audio", "image", "predict", "background" ]
+
+# Reads from the same file that are this close together are coalesced
+# into a single read.
+IO_COALESCE_GAP = 64 * 1024
+
+# The largest coalesced read.
+IO_COALESCE_MAX = 8 * 1024 * 1024
+
+# The largest audio file read into memory. Larger audio files are streamed,
+# so playback can start before they're read, and only this much of their
+# start is read ahead through the scheduler.
+IO_AUDIO_MAX_READ = 256 * 1024
+
+
+class IORequest(object):
+    """
+    A read of `length` bytes at `offset` in the file `fn`, queued with
+    the I/O scheduler.
+    """
+
+    def __init__(self, priority, fn, offset, length, prefix, wait):
+        self.priority = priority
+        self.fn = fn
+        self.offset = offset
+        self.length = length
+
+        # Bytes that come before the data read from the file. (Used by
+        # archives that store the start of files in the index.)
+        self.prefix = prefix
+
+        # The time the request was queued.
+        self.queued = time.time()
+
+        # The data read, or None if the read failed. If this request
+        # doesn't need to be waited on, the data is discarded.
+        self.data = None
+
+        self.done = threading.Event() if wait else None
+
+
+# A heap of [ priority, serial, request ] lists. The request is set to
+# None when it's been coalesced into another read.
+io_queue = [ ]
+
+# The serial number of the next request, used to keep the queue FIFO
+# within each priority.
+io_serial = 0
+
+# Protects io_queue and io_stats.
+io_condition = threading.Condition()
+
+# The thread that performs the reads.
+io_thread = None
+
+# A map from the priority to a [ count, total wait, maximum wait ] list.
+io_latency = { }
+
+# A map from a (filename, inode, mtime) tuple to an open file object, for
+# the archives and files the I/O thread is reading. Including the inode and
+# mtime means a file that's been replaced is opened again. The files are
+# closed whenever the queue empties.
+io_files = { }
+
+
+def io_enabled():
+    """
+    Returns true if the I/O scheduler should be used.
+    """
+
+    if not renpy.config.io_scheduler:
+        return False
+
+    if renpy.emscripten or renpy.android:
+        return False
+
+    return True
+
+
+def locate_core(name):
+    """
+    Returns a (filename, offset, length, prefix) tuple giving where the
+    data for `name` can be found, or None if it can't be found or can
+    only be loaded by load_core.
+    """
+
+    name = lower_map.get(unicodedata.normalize('NFC', name.lower()), name)
+
+    if renpy.config.file_open_callback:
+        return None
+
+    # If a creator has added a callback, files have to be opened through
+    # the callbacks, which may find the file somewhere else first.
+    for i in file_open_callbacks:
+        if i not in builtin_file_open_callbacks:
+            return None
+
+    if not renpy.config.force_archives:
+        try:
+            fn = transfn(name)
+            return fn, 0, os.path.getsize(fn), b''
+        except Exception:
+            pass
+
+    for prefix, index in archives:
+        if not name in index:
+            continue
+
+        if len(index[name]) != 1:
+            return None
+
+        t = index[name][0]
+
+        if len(t) == 2:
+            offset, dlen = t
+            start = b''
+        else:
+            offset, dlen, start = t
+
+        start = start or b''
+
+        return transfn(prefix), offset, dlen - len(start), start
+
+    return None
+
+
+def locate(name, directory=None, tl=True):
+    """
+    Finds where the data for `name` is stored, searching the same places
+    load does. Returns a tuple as for locate_core, or None.
+    """
+
+    for p in get_prefixes(directory=directory, tl=tl):
+        if loadable_core(p + name):
+            return locate_core(p + name)
+
+    return None
+
+
+def io_enqueue(request):
+    """
+    Adds `request` to the queue, starting the I/O thread if necessary.
+    """
+
+    global io_serial
+    global io_thread
+
+    with io_condition:
+
+        if io_thread is None:
+            io_thread = threading.Thread(target=io_thread_main, name="io")
+            io_thread.daemon = True
+            io_thread.start()
+
+        io_serial += 1
+        heapq.heappush(io_queue, [ request.priority, io_serial, request ])
+        io_condition.notify()
+
+
+def scheduled_read(name, directory, tl, priority):
+    """
+    Reads the file `name` through the I/O scheduler, and returns its
+    contents. Returns None if the file can't be read this way, in which
+    case the caller should open it normally.
+    """
+
+    location = locate(name, directory, tl)
+
+    if location is None:
+        return None
+
+    fn, offset, length, prefix = location
+
+    if threading.current_thread() is io_thread:
+        return None
+
+    if priority == IO_AUDIO:
+        max_read = IO_AUDIO_MAX_READ
+    else:
+        max_read = renpy.config.io_scheduler_max_read
+
+    if length > max_read:
+
+        # Warm the disk cache with the start of a streamed audio file.
+        if priority == IO_AUDIO:
+            io_enqueue(IORequest(priority, fn, offset, max_read, prefix, False))
+
+        return None
+
+    request = IORequest(priority, fn, offset, length, prefix, True)
+    io_enqueue(request)
+    request.done.wait()
+
+    return request.data
+
+
+def prefetch(name, priority=IO_BACKGROUND, directory=None, tl=True):
+    """
+    Queues `name` to be read by the I/O scheduler, so it's in the operating
+    system's disk cache when it's needed. The data read is discarded.
+    """
+
+    if not io_enabled():
+        return
+
+    try:
+        location = locate(name, directory, tl)
+    except Exception:
+        return
+
+    if location is None:
+        return
+
+    fn, offset, length, prefix = location
+
+    io_enqueue(IORequest(priority, fn, offset, min(length, renpy.config.io_scheduler_max_read), prefix, False))
+
+
+def io_take():
+    """
+    Removes the most urgent request from the queue, along with any queued
+    requests that read the same file close to it, and returns a list of
+    the requests, sorted by offset. This must be called with io_condition
+    held.
+    """
+
+    _priority, _serial, first = heapq.heappop(io_queue)
+
+    rv = [ first ]
+
+    start = first.offset
+    end = first.offset + first.length
+
+    candidates = [ i for i in io_queue if i[2].fn == first.fn ]
+
+    if not candidates:
+        return rv
+
+    candidates.sort(key=lambda i : i[2].offset)
+
+    taken = False
+
+    for i in candidates:
+        r = i[2]
+
+        if r.offset > end + IO_COALESCE_GAP:
+            continue
+
+        if r.offset + r.length < start - IO_COALESCE_GAP:
+            continue
+
+        new_start = min(start, r.offset)
+        new_end = max(end, r.offset + r.length)
+
+        if new_end - new_start > IO_COALESCE_MAX:
+            continue
+
+        start = new_start
+        end = new_end
+
+        rv.append(r)
+        i[2] = None
+        taken = True
+
+    if taken:
+        io_queue[:] = [ i for i in io_queue if i[2] is not None ]
+        heapq.heapify(io_queue)
+
+    rv.sort(key=lambda r : r.offset)
+
+    return rv
+
+
+def io_read(requests):
+    """
+    Performs a single read covering all of `requests`, which must all be
+    for the same file, and splits the data among them.
+    """
+
+    fn = requests[0].fn
+
+    start = min(r.offset for r in requests)
+    end = max(r.offset + r.length for r in requests)
+
+    try:
+        st = os.stat(fn)
+        key = (fn, st.st_ino, st.st_mtime)
+
+        f = io_files.get(key, None)
+
+        if f is None:
+
+            if len(io_files) >= 8:
+                io_close_files()
+
+            f = io_files[key] = open(fn, "rb")
+
+        f.seek(start)
+        data = f.read(end - start)
+
+    except Exception:
+        data = None
+
+    now = time.time()
+
+    for r in requests:
+
+        if (data is not None) and (r.done is not None):
+            r.data = r.prefix + data[r.offset - start:r.offset - start + r.length]
+
+        with io_condition:
+            wait = now - r.queued
+            stats = io_latency.setdefault(r.priority, [ 0, 0.0, 0.0 ])
+            stats[0] += 1
+            stats[1] += wait
+            stats[2] = max(stats[2], wait)
+
+        if r.done is not None:
+            r.done.set()
+
+
+def io_close_files():
+    """
+    Closes the files the I/O thread has open.
+    """
+
+    for i in io_files.values():
+        i.close()
+
+    io_files.clear()
+
+
+def io_thread_main():
+
+    while True:
+
+        with io_condition:
+            while not io_queue:
+                io_condition.wait()
+
+            requests = io_take()
+
+        io_read(requests)
+
+        with io_condition:
+            idle = not io_queue
+
+        # Don't hold files open while idle, so they can be replaced.
+        if idle:
+            io_close_files()
+
+
+def io_stats():
+    """
+    Returns a dict mapping the name of each I/O class to a (count, mean
+    latency, maximum latency) tuple, with the latencies being the time
+    reads waited in the queue, in seconds.
+    """
+
+    rv = { }
+
+    with io_condition:
+        for priority, (count, total, maximum) in io_latency.items():
+            rv[IO_CLASS_NAMES[priority]] = (count, total / count, maximum)
+
+    return rv
+
+
+def log_io_stats():
+    """
+    Writes the I/O scheduler statistics to log.txt.
+    """
+
+    for name, (count, mean, maximum) in sorted(io_stats().items()):
+        renpy.display.log.write("I/O %s: %d reads, %.1f ms mean wait, %.1f ms max wait.", name, count, mean * 1000, maximum * 1000)
+
+
 def loadable_core(name):
     """
     Returns True if the name is loadable with load, False if it is not.
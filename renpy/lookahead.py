@@ -0,0 +1,440 @@
+# Copyright 2004-2023 Tom Rothamel <pytom@bishoujo.us>
+#
+# Permission is hereby granted, free of charge, to any person
+# obtaining a copy of this software and associated documentation files
+# (the "Software"), to deal in the Software without restriction,
+# including without limitation the rights to use, copy, modify, merge,
+# publish, distribute, sublicense, and/or sell copies of the Software,
+# and to permit persons to whom the Software is furnished to do so,
+# subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be
+# included in all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+# EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+# NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+# LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+# OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+# WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+# This performs lookahead analysis of the script. The first time an
+# interacting statement is predicted, the statements reachable from it are
+# walked without being executed, and the images, fonts, and audio files
+# they use are recorded. The results are stored in the cache alongside the
+# script, and used at runtime to start loading those assets well before
+# ordinary prediction would reach them.
+
+from __future__ import division, absolute_import, with_statement, print_function, unicode_literals
+from renpy.compat import PY2, basestring, bchr, bord, chr, open, pystr, range, round, str, tobytes, unicode # *
+
+from renpy.compat.pickle import loads, dumps
+
+import ast
+import collections
+import hashlib
+import re
+import zlib
+
+import renpy
+
+# The version of the lookahead cache. Change this to force the analysis
+# to be redone.
+LOOKAHEAD_VERSION = 1
+
+CACHE_FILENAME = "cache/lookahead.rpyb"
+
+# A map from the name of a statement to an Assets object giving what is
+# used by the statements reachable from it.
+lookahead = { }
+
+# True if lookahead has changed since it was loaded from the cache.
+updated = False
+
+# The user statements that play audio, and the kind of file they take.
+AUDIO_STATEMENTS = {
+    "play" : "audio",
+    "queue" : "audio",
+    "voice" : "voice",
+    }
+
+FONT_TAG_RE = re.compile(r'(?<!\{)\{font=([^}]+)\}')
+NAME_RE = re.compile(r'^[a-zA-Z_]\w*(\.[a-zA-Z_]\w*)*$')
+SPEC_RE = re.compile(r'^<.*?>')
+
+
+class Assets(collections.namedtuple("Assets", [ "images", "fonts", "audio" ])):
+    """
+    The assets used by a statement or set of statements.
+
+    `images`
+        A tuple of (name, layer) tuples, giving images that are shown.
+
+    `fonts`
+        A tuple of font filenames.
+
+    `audio`
+        A tuple of (kind, expression) tuples, where kind is "audio" or
+        "voice", and expression is a string that evaluates to the file
+        or files to play.
+    """
+
+    __slots__ = ()
+
+
+NO_ASSETS = Assets((), (), ())
+
+
+def direct_assets(node):
+    """
+    Returns the Assets used by `node` itself, or None if it doesn't use any
+    that can be determined without executing it.
+    """
+
+    images = [ ]
+    fonts = [ ]
+    audio = [ ]
+
+    def text(s):
+        if isinstance(s, basestring) and "{font=" in s:
+            fonts.extend(FONT_TAG_RE.findall(s))
+
+    if isinstance(node, (renpy.ast.Show, renpy.ast.Scene)):
+        imspec = node.imspec
+
+        if imspec is not None:
+            if len(imspec) >= 6:
+                name, expression, _tag, _at_list, layer = imspec[:5]
+            else:
+                name, _at_list, layer = imspec
+                expression = None
+
+            if not expression:
+                images.append((tuple(name), layer))
+
+    elif isinstance(node, renpy.ast.Say):
+        text(node.what)
+
+    elif isinstance(node, renpy.ast.Menu):
+        for label, _condition, _block in node.items:
+            text(label)
+
+    elif isinstance(node, renpy.ast.UserStatement):
+        parsed = node.parsed
+
+        if parsed is not None:
+            name, data = parsed
+            kind = AUDIO_STATEMENTS.get(name[0], None)
+
+            if kind is not None:
+                if isinstance(data, dict):
+                    expr = data.get("file", None)
+                else:
+                    expr = data
+
+                if isinstance(expr, basestring) and is_static(expr):
+                    audio.append((kind, expr))
+
+    if not (images or fonts or audio):
+        return None
+
+    return Assets(tuple(images), tuple(fonts), tuple(audio))
+
+
+def is_static(expr):
+    """
+    Returns true if `expr` can be evaluated during prediction without
+    side effects - that is, it's a literal or a name in the audio namespace.
+    """
+
+    if NAME_RE.match(expr.strip()):
+        return True
+
+    try:
+        ast.literal_eval(expr)
+        return True
+    except Exception:
+        return False
+
+
+def successors(node):
+    """
+    Returns a list of the statements that may run after `node`, considering
+    every branch, without executing anything.
+    """
+
+    rv = [ node.next ]
+
+    lookup = renpy.game.script.lookup_or_none
+
+    if isinstance(node, renpy.ast.If):
+        for _condition, block in node.entries:
+            if block:
+                rv.append(block[0])
+
+    elif isinstance(node, renpy.ast.Menu):
+        for _label, _condition, block in node.items:
+            if block:
+                rv.append(block[0])
+
+    elif isinstance(node, renpy.ast.Call):
+        if not node.expression:
+            rv.append(lookup(node.label))
+
+    elif isinstance(node, renpy.ast.Jump):
+        if not node.expression:
+            rv = [ lookup(node.target) ]
+
+    elif isinstance(node, renpy.ast.UserStatement):
+        if node.code_block:
+            rv.append(node.code_block[0])
+
+        for i in node.subparses:
+            if i.block:
+                rv.append(i.block[0])
+
+    elif isinstance(node, (renpy.ast.While, renpy.ast.Label, renpy.ast.Translate)):
+        if node.block:
+            rv.append(node.block[0])
+
+    return [ i for i in rv if i is not None ]
+
+
+def is_root(node):
+    """
+    Returns true if `node` is a statement that prediction might start
+    from, and so should have its lookahead recorded.
+    """
+
+    return isinstance(node, (renpy.ast.Say, renpy.ast.Menu, renpy.ast.UserStatement, renpy.ast.Label))
+
+
+# Caches of the direct assets and successors of each node, shared between
+# the statements analyzed this session.
+direct_cache = { }
+successors_cache = { }
+
+# Used to intern Assets, as many statements share the same ones.
+interned = { NO_ASSETS : NO_ASSETS }
+
+
+def analyze(root):
+    """
+    Returns the Assets used by the statements reachable from `root`, within
+    config.lookahead_statements statements.
+    """
+
+    images = { }
+    fonts = { }
+    audio = { }
+
+    queue = [ root ]
+    seen = set(queue)
+
+    for i in range(renpy.config.lookahead_statements):
+
+        if i >= len(queue):
+            break
+
+        node = queue[i]
+
+        try:
+            direct = direct_cache[node]
+        except KeyError:
+            direct = direct_cache[node] = direct_assets(node)
+
+        if direct is not None:
+            images.update(dict.fromkeys(direct.images))
+            fonts.update(dict.fromkeys(direct.fonts))
+            audio.update(dict.fromkeys(direct.audio))
+
+        try:
+            succ = successors_cache[node]
+        except KeyError:
+            succ = successors_cache[node] = successors(node)
+
+        for n in succ:
+            if n not in seen:
+                seen.add(n)
+                queue.append(n)
+
+    assets = Assets(tuple(images), tuple(fonts), tuple(audio))
+
+    return interned.setdefault(assets, assets)
+
+
+def get_assets(name):
+    """
+    Returns the Assets recorded for the statement named `name`, analyzing
+    it if it isn't in the cache, or None if the statement isn't one that
+    lookahead is recorded for.
+
+    Statements are analyzed the first time they're predicted, rather than
+    when the script is loaded, so that a change to the script doesn't
+    require the whole script to be analyzed at startup.
+    """
+
+    global updated
+
+    rv = lookahead.get(name, None)
+
+    if rv is not None:
+        return rv
+
+    if not renpy.config.lookahead_statements:
+        return None
+
+    node = renpy.game.script.namemap.get(name, None)
+
+    if (node is None) or (node.name != name) or not is_root(node):
+        return None
+
+    rv = lookahead[name] = analyze(node)
+    updated = True
+
+    return rv
+
+
+def load_cache():
+    """
+    Loads the lookahead cache, if it matches the current script.
+    """
+
+    if renpy.game.args.compile: # type: ignore
+        return
+
+    try:
+        with renpy.loader.load(CACHE_FILENAME) as f:
+            digest = f.read(hashlib.md5().digest_size)
+            if digest != renpy.game.script.digest.digest():
+                return
+
+            version, statements, data = loads(zlib.decompress(f.read()))
+
+        if (version == LOOKAHEAD_VERSION) and (statements == renpy.config.lookahead_statements):
+            lookahead.update(data)
+
+    except Exception:
+        pass
+
+
+def save_cache():
+    """
+    Saves the lookahead cache, if it's changed.
+    """
+
+    if not updated:
+        return
+
+    if renpy.macapp:
+        return
+
+    try:
+        data = zlib.compress(dumps((LOOKAHEAD_VERSION, renpy.config.lookahead_statements, lookahead)), 3)
+
+        with open(renpy.loader.get_path(CACHE_FILENAME), "wb") as f:
+            f.write(renpy.game.script.digest.digest())
+            f.write(data)
+    except Exception:
+        pass
+
+
+################################################################################
+# Runtime.
+
+# The audio files that have been prefetched.
+prefetched = set()
+
+
+def prefetch_audio(fn):
+    """
+    Queues the audio file `fn` to be read in the background, so it's in
+    the disk cache when it's played.
+    """
+
+    if fn in prefetched:
+        return
+
+    prefetched.add(fn)
+
+    renpy.loader.prefetch(fn, renpy.loader.IO_BACKGROUND, directory="audio")
+
+
+def predict_audio(kind, expr):
+
+    files = eval(expr, renpy.store.__dict__, renpy.store.audio.__dict__) # type: ignore
+
+    if isinstance(files, basestring):
+        files = [ files ]
+
+    for fn in files:
+
+        if not isinstance(fn, basestring):
+            continue
+
+        if isinstance(fn, renpy.audio.audio.AudioData):
+            continue
+
+        if kind == "voice":
+            fn = renpy.config.voice_filename_format.format(filename=fn) # type: ignore
+
+        # Strip a partial playback specifier.
+        fn = SPEC_RE.sub("", fn)
+
+        prefetch_audio(fn)
+
+
+def predict(name):
+    """
+    A generator that predicts the assets recorded as being used in the
+    lookahead window of the statement named `name`. This yields after
+    predicting each asset.
+    """
+
+    if name is None:
+        return
+
+    assets = get_assets(name)
+
+    if assets is None:
+        return
+
+    context = renpy.game.context()
+    old_images = context.images
+
+    for name, layer in assets.images:
+
+        context.images = renpy.display.image.ShownImageInfo(old_images)
+
+        try:
+            renpy.exports.predict_show(name, layer)
+        except Exception:
+            if renpy.config.debug_prediction:
+                import traceback
+
+                print("While predicting lookahead images.")
+                traceback.print_exc()
+                print()
+
+        context.images = old_images
+
+        yield
+
+    for fn in assets.fonts:
+
+        try:
+            renpy.text.font.load_face(fn, renpy.store.style.default.shaper) # type: ignore
+        except Exception:
+            pass
+
+        yield
+
+    for kind, expr in assets.audio:
+
+        try:
+            predict_audio(kind, expr)
+        except Exception:
+            pass
+
+        yield
@@ -40,6 +40,9 @@ last_clock = time.time()
 def log_clock(s):
     global last_clock
     now = time.time()
+
+    renpy.startupprofile.clock(s.rstrip("."))
+
     s = "{} took {:.2f}s".format(s, now - last_clock)
 
     renpy.display.log.write(s)
@@ -561,8 +564,13 @@ def main():
             if isinstance(node, renpy.ast.Node):
                 node_start = time.time()
 
+                if renpy.startupprofile.enabled:
+                    renpy.startupprofile.begin("Init at {}:{}".format(node.filename, node.linenumber))
+
                 renpy.game.context().run(node)
 
+                renpy.startupprofile.end()
+
                 node_duration = time.time() - node_start
 
                 if node_duration > renpy.config.profile_init:
@@ -601,6 +609,11 @@ def main():
         renpy.atl.compile_all()
         log_clock("Analyze and compile ATL.")
 
+        # Load the assets found reachable from each statement. Statements
+        # that aren't in the cache are analyzed as they're predicted.
+        renpy.lookahead.load_cache()
+        log_clock("Loading lookahead data.")
+
         renpy.savelocation.init()
         renpy.loadsave.init()
         log_clock("Reloading save slot metadata.")
@@ -649,6 +662,12 @@ def main():
 
         log_clock("Initial gc.")
 
+        # If we're a zygote, wait for a launch. This only returns in
+        # the forked child that handles the launch.
+        if renpy.game.args.zygote: # type: ignore
+            renpy.zygote.serve()
+            reset_clock()
+
         # Start debugging file opens.
         renpy.debug.init_main_thread_open()
 
@@ -708,9 +727,14 @@ def main():
             i()
 
         renpy.loader.auto_quit()
+        renpy.loader.log_io_stats()
         renpy.savelocation.quit()
         renpy.translation.write_updated_strings()
 
+        # Statements are analyzed for lookahead as they're predicted, so
+        # the cache is saved once the game is over.
+        renpy.lookahead.save_cache()
+
     # This is stuff we do on a normal, non-error return.
     if not renpy.display.error.error_handled:
         renpy.display.render.check_at_shutdown()
@@ -117,3 +117,43 @@ def analyze():
 
         for i in range(depth, DEPTH_LEVELS):
             times[i] = t
+
+    analyze_gl()
+
+
+def analyze_gl():
+    """
+    Adds the GPU profile of the last frame to the report, if there is one.
+    """
+
+    profile = renpy.exports.get_gl_profile()
+
+    if profile is None:
+        return
+
+    lines = [ ]
+
+    if profile["gpu_ms"] is not None:
+        lines.append("GPU time: {:.3f} ms".format(profile["gpu_ms"]))
+
+    lines.append(", ".join("{} {}".format(k.replace("_", " "), v) for k, v in sorted(profile["counts"].items())))
+
+    for g in profile["groups"][:renpy.config.gl_profile_groups]:
+
+        if g["gpu_ms"] is not None:
+            gpu = "{: 8.3f} ms".format(g["gpu_ms"])
+        else:
+            gpu = ""
+
+        lines.append("{} {:4d} {} {} {}".format(
+            gpu,
+            g["draws"],
+            g["kind"],
+            g["displayable"],
+            ", ".join(g["shaders"])))
+
+    for l in lines:
+        s = l + "\n"
+
+        renpy.log.real_stdout.write(s)
+        renpy.display.log.write(s.replace("%", "%%"))
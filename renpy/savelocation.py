@@ -44,6 +44,13 @@ disk_lock = threading.RLock()
 import time
 tmp = "." + str(int(time.time())) + ".tmp"
 
+# The name of the file, in each save directory, that indexes the metadata
+# of the saves in that directory.
+INDEX_FILENAME = "slots.index"
+
+# The version of the index. Change this to force the index to be rebuilt.
+INDEX_VERSION = 1
+
 
 class FileLocation(object):
     """
@@ -77,6 +84,19 @@ class FileLocation(object):
         # A map from slotname to the mtime of that slot.
         self.mtimes = { }
 
+        # A map from slotname to the size of that slot's file.
+        self.sizes = { }
+
+        # The index file, and the index loaded from it. The index is a map
+        # from slotname to a dict giving the mtime and size of the slot's
+        # file when the entry was made, the json data, and the location of
+        # the screenshot in the file.
+        self.index_filename = os.path.join(self.directory, INDEX_FILENAME)
+        self.index = self.load_index()
+
+        # True if the index has changed since it was loaded or saved.
+        self.index_dirty = False
+
         # The persistent file.
         self.persistent = os.path.join(self.directory, "persistent")
 
@@ -114,22 +134,37 @@ class FileLocation(object):
 
             old_mtimes = self.mtimes
             new_mtimes = { }
+            new_sizes = { }
 
             suffix = renpy.savegame_suffix
             suffix_len = len(suffix)
 
-            for fn in os.listdir(self.directory):
+            for fn, st in self.list_directory():
                 if not fn.endswith(suffix):
                     continue
 
                 slotname = fn[:-suffix_len]
 
                 try:
-                    new_mtimes[slotname] = os.path.getmtime(os.path.join(self.directory, fn))
+                    if st is None:
+                        st = os.stat(os.path.join(self.directory, fn))
+
+                    new_mtimes[slotname] = st.st_mtime
+                    new_sizes[slotname] = st.st_size
                 except Exception:
                     pass
 
             self.mtimes = new_mtimes
+            self.sizes = new_sizes
+
+            # Drop index entries for slots that have changed or been removed.
+            for slotname, entry in list(self.index.items()):
+                if (entry["mtime"] != new_mtimes.get(slotname, None)) or (entry["size"] != new_sizes.get(slotname, None)):
+                    del self.index[slotname]
+                    self.index_dirty = True
+
+            if self.index_dirty:
+                self.save_index()
 
             for slotname, mtime in new_mtimes.items():
                 if old_mtimes.get(slotname, None) != mtime:
@@ -150,6 +185,139 @@ class FileLocation(object):
                             self.persistent_data = data
                             break
 
+    def list_directory(self):
+        """
+        Returns a list of (filename, stat) pairs for the files in the
+        directory. The stat is None if it has to be retrieved separately.
+        """
+
+        if PY2:
+            return [ (fn, None) for fn in os.listdir(self.directory) ]
+
+        rv = [ ]
+
+        for entry in os.scandir(self.directory):
+            try:
+                rv.append((entry.name, entry.stat()))
+            except Exception:
+                pass
+
+        return rv
+
+    def load_index(self):
+        """
+        Loads the slot index from disk, returning an empty index if it
+        doesn't exist or can't be read.
+        """
+
+        try:
+            with open(self.index_filename, "rb") as f:
+                data = json.loads(f.read().decode("utf-8"))
+
+            if data["version"] != INDEX_VERSION:
+                return { }
+
+            return data["slots"]
+
+        except Exception:
+            return { }
+
+    def save_index(self):
+        """
+        Writes the slot index to disk.
+        """
+
+        with disk_lock:
+
+            self.index_dirty = False
+
+            if not self.active:
+                return
+
+            data = json.dumps({ "version" : INDEX_VERSION, "slots" : self.index })
+
+            try:
+                fn = self.index_filename
+                fn_tmp = fn + tmp
+
+                with open(fn_tmp, "wb") as f:
+                    f.write(data.encode("utf-8"))
+
+                safe_rename(fn_tmp, fn)
+
+            except Exception:
+                pass
+
+    def read_index_entry(self, slotname):
+        """
+        Reads the metadata of slotname from its file, returning a new index
+        entry, or None if the file can't be read.
+        """
+
+        try:
+            filename = self.filename(slotname)
+            with zipfile.ZipFile(filename, "r") as zf:
+
+                data = { }
+
+                try:
+                    data = json.loads(zf.read("json"))
+                except Exception:
+                    try:
+                        extra_info = zf.read("extra_info").decode("utf-8")
+                        data = { "_save_name" : extra_info }
+                    except Exception:
+                        pass
+
+                screenshot = None
+
+                for name in [ "screenshot.tga", "screenshot.png" ]:
+                    try:
+                        info = zf.getinfo(name)
+                    except KeyError:
+                        continue
+
+                    screenshot = [ name, info.header_offset, info.compress_size, info.compress_type ]
+                    break
+
+        except Exception:
+            return None
+
+        return { "json" : data, "screenshot" : screenshot }
+
+    def index_entry(self, slotname):
+        """
+        Returns the index entry for slotname, reading it from the slot's
+        file and adding it to the index if necessary. Returns None if the
+        slot is empty.
+        """
+
+        with disk_lock:
+
+            mtime = self.mtimes.get(slotname, None)
+
+            # The slot hasn't been scanned, so its entry can't be validated.
+            if mtime is None:
+                return self.read_index_entry(slotname)
+
+            entry = self.index.get(slotname, None)
+
+            if entry is not None:
+                return entry
+
+            entry = self.read_index_entry(slotname)
+
+            if entry is None:
+                return None
+
+            entry["mtime"] = mtime
+            entry["size"] = self.sizes.get(slotname, None)
+
+            self.index[slotname] = entry
+            self.index_dirty = True
+
+            return entry
+
     def save(self, slotname, record):
         """
         Saves the save record in slotname.
@@ -165,6 +333,10 @@ class FileLocation(object):
         self.sync()
         self.scan()
 
+        # Index the new save right away, so the save screen doesn't need to.
+        if self.index_entry(slotname) is not None:
+            self.save_index()
+
     def list(self):
         """
         Returns a list of all slots with savefiles in them, in arbitrary
@@ -217,27 +389,12 @@ class FileLocation(object):
         Returns None if the slot is empty.
         """
 
-        with disk_lock:
+        entry = self.index_entry(slotname)
 
-            try:
-                filename = self.filename(slotname)
-                with zipfile.ZipFile(filename, "r") as zf:
-                    try:
-                        data = zf.read("json")
-                        data = json.loads(data)
-                        return data
-                    except Exception:
-                        pass
+        if entry is None:
+            return None
 
-                    try:
-                        extra_info = zf.read("extra_info").decode("utf-8")
-                        return { "_save_name" : extra_info }
-                    except Exception:
-                        pass
-
-                    return { }
-            except Exception:
-                return None
+        return dict(entry["json"])
 
     def screenshot(self, slotname):
         """
@@ -246,31 +403,19 @@ class FileLocation(object):
         Returns None if the slot is empty.
         """
 
-        with disk_lock:
+        mtime = self.mtime(slotname)
 
-            mtime = self.mtime(slotname)
+        if mtime is None:
+            return None
 
-            if mtime is None:
-                return None
+        entry = self.index_entry(slotname)
 
-            try:
-                filename = self.filename(slotname)
-                with zipfile.ZipFile(filename, "r") as zf:
-                    try:
-                        png = False
-                        zf.getinfo('screenshot.tga')
-                    except Exception:
-                        png = True
-                        zf.getinfo('screenshot.png')
-            except Exception:
-                return None
+        if (entry is None) or (entry["screenshot"] is None):
+            return None
 
-            if png:
-                screenshot = renpy.display.im.ZipFileImage(filename, "screenshot.png", mtime)
-            else:
-                screenshot = renpy.display.im.ZipFileImage(filename, "screenshot.tga", mtime)
+        name, offset, size, compress_type = entry["screenshot"]
 
-            return screenshot
+        return renpy.display.im.ZipFileImage(self.filename(slotname), name, mtime, member=(offset, size, compress_type))
 
     def load(self, slotname):
         """
@@ -312,16 +457,27 @@ class FileLocation(object):
 
         with disk_lock:
 
-            old = self.filename(old)
-            new = self.filename(new)
+            old_filename = self.filename(old)
+            new_filename = self.filename(new)
 
-            if not os.path.exists(old):
+            if not os.path.exists(old_filename):
                 return
 
-            old_tmp = old + tmp
-            safe_rename(old, old_tmp)
-            safe_rename(old_tmp, new)
-            renpy.util.expose_file(new)
+            old_tmp = old_filename + tmp
+            safe_rename(old_filename, old_tmp)
+            safe_rename(old_tmp, new_filename)
+            renpy.util.expose_file(new_filename)
+
+            # A rename preserves the mtime and contents of the file, so the
+            # index entry remains valid under the new name.
+            entry = self.index.pop(old, None)
+
+            if entry is not None:
+                self.index[new] = entry
+            else:
+                self.index.pop(new, None)
+
+            self.index_dirty = True
 
             self.sync()
             self.scan()
@@ -634,6 +790,24 @@ def init():
         scan_thread.start()
 
 
+def after_fork():
+    """
+    Called in a child forked by the zygote, where the scan thread doesn't
+    exist. Recreates the locks, and restarts the thread.
+    """
+
+    global scan_thread
+    global scan_thread_condition
+    global disk_lock
+
+    disk_lock = threading.RLock()
+    scan_thread_condition = threading.Condition()
+
+    if scan_thread is not None:
+        scan_thread = threading.Thread(target=run_scan_thread)
+        scan_thread.start()
+
+
 def zip_saves():
     """
     This is called directly from Javascript, to zip up the savegames
@@ -307,7 +307,8 @@ class Script(object):
             # our process as unresponsive by OS
             renpy.display.presplash.pump_window()
 
-            self.load_appropriate_file(".rpyc", [ "_ren.py", ".rpy" ], dir, fn, initcode)
+            with renpy.startupprofile.phase(fn):
+                self.load_appropriate_file(".rpyc", [ "_ren.py", ".rpy" ], dir, fn, initcode)
 
         initcode.sort(key=lambda i: i[0])
 
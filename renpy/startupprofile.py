@@ -0,0 +1,280 @@
+# Copyright 2004-2023 Tom Rothamel <pytom@bishoujo.us>
+#
+# Permission is hereby granted, free of charge, to any person
+# obtaining a copy of this software and associated documentation files
+# (the "Software"), to deal in the Software without restriction,
+# including without limitation the rights to use, copy, modify, merge,
+# publish, distribute, sublicense, and/or sell copies of the Software,
+# and to permit persons to whom the Software is furnished to do so,
+# subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be
+# included in all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+# EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+# NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+# LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+# OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+# WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+# This records a timeline of Ren'Py startup, from bootstrap until the first
+# frame is drawn. Each phase records the wall and CPU time it took, the
+# number of bytes read, and the number of objects unpickled. The timeline
+# is written out in the Chrome trace event format, which can be viewed
+# in about:tracing or Perfetto, and summarized in log.txt.
+
+from __future__ import division, absolute_import, with_statement, print_function, unicode_literals
+from renpy.compat import PY2, basestring, bchr, bord, chr, open, pystr, range, round, str, tobytes, unicode # *
+
+import contextlib
+import json
+import os
+import sys
+import time
+
+import renpy
+
+try:
+    process_time = time.process_time
+except AttributeError:
+    process_time = time.clock # type: ignore
+
+# Is startup profiling enabled?
+enabled = False
+
+# The file the trace is written to.
+filename = None
+
+# Should Ren'Py quit once the first frame has been drawn?
+quit_after = False
+
+# The time the profile started at.
+start_time = 0.0
+
+# The number of objects that have been unpickled. This is approximated
+# by the number of memory blocks allocated while unpickling.
+unpickled_objects = 0
+
+# The stack of open phases. Each is a [ name, start counters, clock
+# counters ] list, where the clock counters are the counters at the time
+# of the last clock inside that phase.
+stack = [ ]
+
+# A list of completed phases, as (name, depth, start counters, end
+# counters) tuples.
+phases = [ ]
+
+
+def read_bytes():
+    """
+    Returns the number of bytes this process has read, or 0 if that is not
+    known.
+    """
+
+    try:
+        with open("/proc/self/io", "r") as f:
+            for l in f:
+                if l.startswith("rchar:"):
+                    return int(l.split()[1])
+    except Exception:
+        pass
+
+    return 0
+
+
+def counters():
+    """
+    Returns a tuple of (wall time, cpu time, bytes read, unpickled objects).
+    """
+
+    return (time.time(), process_time(), read_bytes(), unpickled_objects)
+
+
+def start(fn, quit=False): # @ReservedAssignment
+    """
+    Starts profiling startup, with the trace to be written to `fn`.
+    """
+
+    global enabled
+    global filename
+    global quit_after
+    global start_time
+
+    enabled = True
+    filename = fn
+    quit_after = quit
+
+    c = counters()
+    start_time = c[0]
+
+    stack.append([ "Startup", c, c ])
+
+
+def begin(name):
+    """
+    Opens a phase named `name`. Phases opened while it is open, and clocks
+    marked while it is open, are nested inside it.
+    """
+
+    if not enabled:
+        return
+
+    c = counters()
+    stack.append([ name, c, c ])
+
+
+def end():
+    """
+    Closes the most recently opened phase.
+    """
+
+    if not enabled or len(stack) < 2:
+        return
+
+    name, c, _ = stack.pop()
+    phases.append((name, len(stack), c, counters()))
+
+
+@contextlib.contextmanager
+def phase(name):
+    """
+    A context manager that opens a phase named `name` while its block
+    runs.
+    """
+
+    begin(name)
+
+    try:
+        yield
+    finally:
+        end()
+
+
+def clock(name):
+    """
+    Records a phase named `name` that covers the time since the innermost
+    open phase began, or the last clock in that phase. This is called by
+    renpy.main.log_clock.
+    """
+
+    if not enabled:
+        return
+
+    c = counters()
+    phases.append((name, len(stack), stack[-1][2], c))
+    stack[-1][2] = c
+
+
+def unpickle_start():
+    """
+    Called before unpickling. Returns a token to be passed to unpickle_end.
+    """
+
+    return getattr(sys, "getallocatedblocks", int)()
+
+
+def unpickle_end(token):
+    """
+    Called after unpickling, to count the objects created.
+    """
+
+    global unpickled_objects
+
+    blocks = getattr(sys, "getallocatedblocks", int)() - token
+
+    if blocks > 0:
+        unpickled_objects += blocks
+
+
+def args(c0, c1):
+    """
+    Returns a dictionary giving the difference in counters between `c0`
+    and `c1`.
+    """
+
+    return {
+        "cpu_ms" : round((c1[1] - c0[1]) * 1000, 3),
+        "read_bytes" : c1[2] - c0[2],
+        "unpickled_objects" : c1[3] - c0[3],
+        }
+
+
+def finish():
+    """
+    Called when the first frame has been drawn. This closes any open
+    phases, writes out the trace, and logs a report.
+    """
+
+    global enabled
+
+    if not enabled:
+        return
+
+    clock("Running until the first frame")
+
+    while len(stack) > 1:
+        end()
+
+    name, c0, _ = stack.pop()
+    c1 = counters()
+    phases.append((name, 0, c0, c1))
+
+    enabled = False
+
+    pid = os.getpid()
+    events = [ ]
+
+    for name, depth, c0, c1 in phases:
+        events.append({
+            "name" : name,
+            "cat" : "startup",
+            "ph" : "X",
+            "ts" : round((c0[0] - start_time) * 1000000),
+            "dur" : round((c1[0] - c0[0]) * 1000000),
+            "pid" : pid,
+            "tid" : 0,
+            "args" : args(c0, c1),
+            })
+
+    # Sort by start time, then outermost first, so that viewers nest the
+    # phases properly.
+    events.sort(key=lambda e : (e["ts"], -e["dur"]))
+
+    try:
+        with open(filename, "w") as f:
+            json.dump({ "traceEvents" : events, "displayTimeUnit" : "ms" }, f, indent=1)
+    except Exception as e:
+        renpy.display.log.write("Could not write startup profile to %r: %r", filename, e)
+
+    report()
+
+    if quit_after:
+        raise renpy.game.QuitException()
+
+
+def report():
+    """
+    Writes a summary of the startup profile to the log, giving the total
+    time and the slowest phases.
+    """
+
+    write = renpy.display.log.write
+
+    total = [ i for i in phases if i[1] == 0 ][-1]
+    name, depth, c0, c1 = total
+
+    write("")
+    write("Startup profile (written to %s):", filename)
+    write(" - Total %.1f ms wall, %.1f ms cpu, %d bytes read, %d objects unpickled.",
+        (c1[0] - c0[0]) * 1000, (c1[1] - c0[1]) * 1000, c1[2] - c0[2], c1[3] - c0[3])
+
+    leaves = [ i for i in phases if i is not total ]
+    leaves.sort(key=lambda i : i[2][0] - i[3][0])
+
+    for name, depth, c0, c1 in leaves[:renpy.config.startup_profile_report]:
+        write(" - %-40s %8.1f ms wall %8.1f ms cpu %10d bytes %8d objects",
+            name, (c1[0] - c0[0]) * 1000, (c1[1] - c0[1]) * 1000, c1[2] - c0[2], c1[3] - c0[3])
+
+    write("")
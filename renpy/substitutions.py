@@ -31,6 +31,12 @@ import renpy
 import string
 import os
 
+if PY2:
+    def field_name_split(name):
+        return name._formatter_field_name_split()
+else:
+    from _string import formatter_field_name_split as field_name_split
+
 update_translations = "RENPY_UPDATE_TRANSLATIONS" in os.environ
 
 
@@ -164,6 +170,15 @@ class Formatter(string.Formatter):
         if literal:
             yield (literal, None, None, None)
 
+    def vformat(self, format_string, args, kwargs):
+        if not args:
+            template = get_template(format_string)
+
+            if template is not None:
+                return template.format(kwargs)
+
+        return super(Formatter, self).vformat(format_string, args, kwargs)
+
     def get_field(self, field_name, args, kwargs):
         obj, arg_used = super(Formatter, self).get_field(field_name, args, kwargs)
 
@@ -175,11 +190,15 @@ class Formatter(string.Formatter):
         if conversion is None:
             return value
 
-        if not conversion:
-            raise ValueError("Conversion specifier can't be empty.")
+        check_conversion(conversion)
+
+        return self.convert(value, conversion, kwargs)
 
-        if set(conversion) - set("rstqulci!"):
-            raise ValueError("Unknown symbols in conversion specifier, this must use only the \"rstqulci\".")
+    def convert(self, value, conversion, kwargs):
+        """
+        Applies `conversion`, which must have been checked with
+        check_conversion, to `value`.
+        """
 
         if "r" in conversion:
             value = repr(value)
@@ -219,10 +238,139 @@ class Formatter(string.Formatter):
         return value
 
 
+def check_conversion(conversion):
+    """
+    Raises ValueError if `conversion` isn't a valid conversion specifier.
+    """
+
+    if not conversion:
+        raise ValueError("Conversion specifier can't be empty.")
+
+    if set(conversion) - set("rstqulci!"):
+        raise ValueError("Unknown symbols in conversion specifier, this must use only the \"rstqulci\".")
+
+
 # The instance of Formatter we use.
 formatter = Formatter()
 
 
+class Uncompilable(Exception):
+    """
+    Raised when a string uses formatting that Template doesn't handle,
+    in which case it's formatted by string.Formatter.
+    """
+
+
+class Field(object):
+    """
+    A field in a Template, that looks up a value and formats it.
+    """
+
+    def __init__(self, field_name, format_spec, conversion):
+
+        first, rest = field_name_split(field_name)
+
+        # Positional fields, and format specs with fields of their own.
+        if not isinstance(first, basestring) or not first or ("[" in format_spec):
+            raise Uncompilable()
+
+        if conversion is not None:
+            try:
+                check_conversion(conversion)
+            except ValueError:
+                raise Uncompilable()
+
+        # The name looked up in the scope.
+        self.first = first
+
+        # A list of (is_attr, key) tuples, for the attribute and item
+        # lookups that follow it.
+        self.rest = list(rest)
+
+        self.format_spec = format_spec
+        self.conversion = conversion
+
+    def format(self, kwargs):
+
+        value = kwargs[self.first]
+
+        for is_attr, key in self.rest:
+            if is_attr:
+                value = getattr(value, key)
+            else:
+                value = value[key]
+
+        if self.conversion is not None:
+            value = formatter.convert(value, self.conversion, kwargs)
+
+        return format(value, self.format_spec)
+
+
+class Template(object):
+    """
+    A string that has been parsed once, so that it can be formatted
+    repeatedly without being parsed again.
+    """
+
+    def __init__(self, s):
+
+        # A list of (literal, field) tuples, where field is a Field or None.
+        self.ops = [ ]
+
+        for literal, field_name, format_spec, conversion in formatter.parse(s):
+
+            if field_name is not None:
+                field = Field(field_name, format_spec, conversion)
+            else:
+                field = None
+
+            self.ops.append((literal, field))
+
+    def format(self, kwargs):
+
+        rv = [ ]
+
+        for literal, field in self.ops:
+            rv.append(literal)
+
+            if field is not None:
+                rv.append(field.format(kwargs))
+
+        return "".join(rv)
+
+
+# A map from a string to the Template it's been compiled into, or None if
+# it can't be compiled.
+templates = { }
+
+# The number of templates that can be cached before the cache is cleared.
+TEMPLATE_CACHE_SIZE = 4096
+
+
+def get_template(s):
+    """
+    Returns the Template for `s`, or None if `s` has to be formatted
+    by string.Formatter.
+    """
+
+    rv = templates.get(s, False)
+
+    if rv is not False:
+        return rv
+
+    try:
+        rv = Template(s)
+    except Uncompilable:
+        rv = None
+
+    if len(templates) >= TEMPLATE_CACHE_SIZE:
+        templates.clear()
+
+    templates[s] = rv
+
+    return rv
+
+
 class MultipleDict(object):
 
     def __init__(self, *dicts):
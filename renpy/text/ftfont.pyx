@@ -28,7 +28,7 @@ import_pygame_sdl2()
 
 from freetype cimport *
 from ttgsubtable cimport *
-from renpy.text.textsupport cimport Glyph, SPLIT_INSTEAD
+from renpy.text.textsupport cimport Glyph, SPLIT_INSTEAD, distance_field, draw_distance_field
 import traceback
 import sys
 
@@ -262,6 +262,11 @@ cdef class FTFont:
 
         glyph_cache cache[256]
 
+        # A map from (glyph index, spread) to the (left, top, width, rows,
+        # field) distance field of that glyph, or False if the glyph is a
+        # color bitmap that doesn't have one.
+        dict sdf_cache
+
         # Have we been setup at least once?
         bint has_setup
 
@@ -269,6 +274,8 @@ cdef class FTFont:
         int hinting
 
     def __cinit__(self):
+        self.sdf_cache = { }
+
         for i from 0 <= i < 256:
             self.cache[i].index = -1
             FT_Bitmap_New(&(self.cache[i].bitmap))
@@ -898,3 +905,77 @@ cdef class FTFont:
                         line[1] = Sg
                         line[2] = Sb
                         line[3] = Sa
+
+    def draw_sdf(self, pysurf, float xo, int yo, color, list glyphs, int spread):
+        """
+        Draws a list of glyphs to surf as a signed distance field, with the
+        baseline starting at x, y. The field of each glyph extends `spread`
+        pixels past its bitmap, and the glyphs are drawn offset by -spread.
+
+        Returns False if one of the glyphs is a color bitmap, which can't
+        be drawn this way, and True otherwise.
+        """
+
+        cdef SDL_Surface *surf
+        cdef unsigned char r, g, b
+        cdef Glyph glyph
+        cdef glyph_cache *cache
+        cdef int x, y, left, top, width, rows
+        cdef bytes field
+        cdef FT_Face face
+        cdef FT_UInt index
+
+        r, g, b = color[:3]
+
+        self.setup()
+
+        surf = PySurface_AsSurface(pysurf)
+        face = self.face
+
+        for glyph in glyphs:
+
+            if glyph.split == SPLIT_INSTEAD:
+                continue
+
+            if not glyph.draw:
+                continue
+
+            x = <int> (glyph.x + xo)
+            y = <int> (glyph.y + yo)
+
+            if glyph.variation == 0:
+                index = FT_Get_Char_Index(face, glyph.character)
+            else:
+                index = FT_Face_GetCharVariantIndex(face, glyph.character, glyph.variation)
+
+            entry = self.sdf_cache.get((index, spread), None)
+
+            if entry is None:
+
+                cache = self.get_glyph(index)
+
+                if cache.bitmap.pixel_mode == FT_PIXEL_MODE_BGRA:
+                    entry = False
+                else:
+                    entry = (
+                        cache.bitmap_left - spread,
+                        cache.bitmap_top + spread,
+                        cache.bitmap.width + 2 * spread,
+                        cache.bitmap.rows + 2 * spread,
+                        distance_field(cache.bitmap.buffer, cache.bitmap.pitch, cache.bitmap.width, cache.bitmap.rows, spread),
+                        )
+
+                self.sdf_cache[(index, spread)] = entry
+
+            if entry is False:
+                return False
+
+            left, top, width, rows, field = entry
+
+            draw_distance_field(
+                <unsigned char *> surf.pixels, surf.pitch, surf.w, surf.h,
+                <int> (x + .5) + left, y - top,
+                <unsigned char *> <char *> field, width, rows,
+                r, g, b)
+
+        return True
@@ -22,13 +22,14 @@
 
 from __future__ import print_function
 
+from libc.stdlib cimport malloc, free
 from sdl2 cimport *
 from pygame_sdl2 cimport *
 import_pygame_sdl2()
 
 from freetype cimport *
 from ttgsubtable cimport *
-from renpy.text.textsupport cimport Glyph, SPLIT_INSTEAD
+from renpy.text.textsupport cimport Glyph, SPLIT_INSTEAD, distance_field, draw_distance_field
 import traceback
 import sys
 
@@ -53,6 +54,18 @@ cdef extern from "hb.h":
     ctypedef void (*hb_destroy_func_t)(void *)
     ctypedef int hb_position_t
 
+    ctypedef int hb_script_t
+
+    struct hb_language_impl_t
+    ctypedef const hb_language_impl_t *hb_language_t
+
+    struct hb_segment_properties_t:
+        hb_direction_t direction
+        hb_script_t script
+        hb_language_t language
+
+    hb_bool_t hb_segment_properties_equal(const hb_segment_properties_t *a, const hb_segment_properties_t *b)
+
     # hb-buffer
     struct hb_glyph_info_t:
         hb_codepoint_t codepoint;
@@ -69,6 +82,7 @@ cdef extern from "hb.h":
     hb_buffer_t *hb_buffer_create()
 
     void hb_buffer_reset(hb_buffer_t *)
+    void hb_buffer_clear_contents(hb_buffer_t *)
 
     void hb_buffer_destroy(hb_buffer_t *)
 
@@ -85,8 +99,15 @@ cdef extern from "hb.h":
         unsigned int item_offset,
         int item_length)
 
+    void hb_buffer_add_codepoints (hb_buffer_t *buffer,
+        const hb_codepoint_t *text,
+        int text_length,
+        unsigned int item_offset,
+        int item_length)
+
     void hb_buffer_set_direction (hb_buffer_t *buffer, hb_direction_t direction)
     void hb_buffer_guess_segment_properties(hb_buffer_t *buffer)
+    void hb_buffer_get_segment_properties(hb_buffer_t *buffer, hb_segment_properties_t *props)
 
     hb_glyph_info_t *hb_buffer_get_glyph_infos (hb_buffer_t *buffer, unsigned int *length);
     hb_glyph_position_t *hb_buffer_get_glyph_positions (hb_buffer_t *buffer, unsigned int *length);
@@ -99,10 +120,14 @@ cdef extern from "hb.h":
 
     void hb_buffer_set_cluster_level(hb_buffer_t *buffer, hb_buffer_cluster_level_t cluster_level)
 
+    # hb-face
+    struct hb_face_t
+
     # hb-font
     struct hb_font_t
 
     void hb_font_destroy(hb_font_t *)
+    hb_face_t *hb_font_get_face(hb_font_t *font)
 
     struct hb_feature_t
 
@@ -116,6 +141,25 @@ cdef extern from "hb.h":
         const hb_feature_t *features,
         unsigned int num_features);
 
+    # hb-shape-plan
+    struct hb_shape_plan_t
+
+    hb_shape_plan_t *hb_shape_plan_create_cached(
+        hb_face_t *face,
+        const hb_segment_properties_t *props,
+        const hb_feature_t *user_features,
+        unsigned int num_user_features,
+        const char * const *shaper_list)
+
+    hb_bool_t hb_shape_plan_execute(
+        hb_shape_plan_t *shape_plan,
+        hb_font_t *font,
+        hb_buffer_t *buffer,
+        const hb_feature_t *features,
+        unsigned int num_features)
+
+    void hb_shape_plan_destroy(hb_shape_plan_t *shape_plan)
+
 
 
 cdef extern from "hb-ft.h":
@@ -128,6 +172,15 @@ cdef extern from "hb-ft.h":
 # The freetype library object we use.
 cdef FT_Library library
 
+# The number of shape plans each font keeps.
+DEF SHAPE_PLANS = 8
+
+# A shape plan, and the script, language, and direction it was made for.
+# (Ren'Py doesn't use OpenType features, so they're not part of the key.)
+cdef struct shape_plan_entry:
+    hb_segment_properties_t props
+    hb_shape_plan_t *plan
+
 # Represents a cached glyph.
 cdef struct glyph_cache:
 
@@ -329,6 +382,11 @@ cdef class HBFont:
 
         glyph_cache cache[256]
 
+        # A map from (glyph index, spread) to the (left, top, width, rows,
+        # field) distance field of that glyph, or False if the glyph is a
+        # color bitmap that doesn't have one.
+        dict sdf_cache
+
         # Have we been setup at least once?
         bint has_setup
 
@@ -338,7 +396,29 @@ cdef class HBFont:
         # The font harfbuzz uses.
         hb_font_t *hb_font
 
+        # The buffer that's reused to shape each run of text.
+        hb_buffer_t *hb_buffer
+
+        # The codepoints of the run being shaped, and the number of
+        # codepoints there's room for.
+        hb_codepoint_t *codepoints
+        int codepoints_size
+
+        # The shape plans that have been made for this font, and the entry
+        # to replace when a new one is needed.
+        shape_plan_entry shape_plans[SHAPE_PLANS]
+        int shape_plan_count
+        int shape_plan_next
+
     def __cinit__(self):
+        self.sdf_cache = { }
+
+        self.hb_buffer = hb_buffer_create()
+        self.codepoints = NULL
+        self.codepoints_size = 0
+        self.shape_plan_count = 0
+        self.shape_plan_next = 0
+
         for i from 0 <= i < 256:
             self.cache[i].index = -1
             FT_Bitmap_New(&(self.cache[i].bitmap))
@@ -350,6 +430,12 @@ cdef class HBFont:
         if self.stroker != NULL:
             FT_Stroker_Done(self.stroker)
 
+        for i from 0 <= i < self.shape_plan_count:
+            hb_shape_plan_destroy(self.shape_plans[i].plan)
+
+        hb_buffer_destroy(self.hb_buffer)
+        free(self.codepoints)
+
 
     def __init__(self, face, float size, float bold, bint italic, int outline, bint antialias, bint vertical, hinting):
 
@@ -584,7 +670,76 @@ cdef class HBFont:
 
         return rv
 
-    def glyphs(self, unicode s):
+    cdef hb_shape_plan_t *get_shape_plan(self, hb_segment_properties_t *props):
+        """
+        Returns a shape plan for text with `props`, reusing one made for
+        an earlier run if possible.
+        """
+
+        cdef int i
+        cdef shape_plan_entry *entry
+
+        for i from 0 <= i < self.shape_plan_count:
+            if hb_segment_properties_equal(&self.shape_plans[i].props, props):
+                return self.shape_plans[i].plan
+
+        if self.shape_plan_count < SHAPE_PLANS:
+            entry = &self.shape_plans[self.shape_plan_count]
+            self.shape_plan_count += 1
+        else:
+            entry = &self.shape_plans[self.shape_plan_next]
+            self.shape_plan_next = (self.shape_plan_next + 1) % SHAPE_PLANS
+            hb_shape_plan_destroy(entry.plan)
+
+        entry.props = props[0]
+        entry.plan = hb_shape_plan_create_cached(hb_font_get_face(self.hb_font), props, NULL, 0, NULL)
+
+        return entry.plan
+
+    cdef int shape(self, unicode s) except -1:
+        """
+        Shapes `s` into self.hb_buffer.
+        """
+
+        cdef int len_s = len(s)
+        cdef int i
+        cdef Py_UCS4 c
+        cdef hb_segment_properties_t props
+
+        if len_s > self.codepoints_size:
+            free(self.codepoints)
+            self.codepoints_size = max(len_s, 2 * self.codepoints_size, 64)
+            self.codepoints = <hb_codepoint_t *> malloc(sizeof(hb_codepoint_t) * self.codepoints_size)
+
+            if self.codepoints == NULL:
+                self.codepoints_size = 0
+                raise MemoryError()
+
+        i = 0
+
+        for c in s:
+            self.codepoints[i] = c
+            i += 1
+
+        hb_buffer_clear_contents(self.hb_buffer)
+        hb_buffer_add_codepoints(self.hb_buffer, self.codepoints, len_s, 0, len_s)
+
+        if self.vertical:
+            hb_buffer_set_direction(self.hb_buffer, HB_DIRECTION_TTB)
+        else:
+            hb_buffer_set_direction(self.hb_buffer, HB_DIRECTION_LTR)
+
+        hb_buffer_guess_segment_properties(self.hb_buffer)
+        hb_buffer_set_cluster_level(self.hb_buffer, HB_BUFFER_CLUSTER_LEVEL_MONOTONE_CHARACTERS)
+
+        hb_buffer_get_segment_properties(self.hb_buffer, &props)
+
+        if not hb_shape_plan_execute(self.get_shape_plan(&props), self.hb_font, self.hb_buffer, NULL, 0):
+            hb_shape(self.hb_font, self.hb_buffer, NULL, 0)
+
+        return 0
+
+    cpdef list glyphs(self, unicode s):
         """
         Sizes s, returning a list of Glyph objects.
         """
@@ -615,20 +770,8 @@ cdef class HBFont:
 
         # Start Harfbuzz
 
-        hb = hb_buffer_create()
-        utf32_s = s.encode("utf-32")
-
-        hb_buffer_add_utf32(hb, <const uint32_t *> ((<const char *> utf32_s) + 4), len(s), 0, len(s));
-
-        if self.vertical:
-            hb_buffer_set_direction(hb, HB_DIRECTION_TTB)
-        else:
-            hb_buffer_set_direction(hb, HB_DIRECTION_LTR)
-
-        hb_buffer_guess_segment_properties(hb)
-        hb_buffer_set_cluster_level(hb, HB_BUFFER_CLUSTER_LEVEL_MONOTONE_CHARACTERS)
-
-        hb_shape(self.hb_font, hb, NULL, 0)
+        self.shape(s)
+        hb = self.hb_buffer
 
         glyph_info = hb_buffer_get_glyph_infos(hb, &glyph_count);
         glyph_pos = hb_buffer_get_glyph_positions(hb, &glyph_count);
@@ -669,8 +812,6 @@ cdef class HBFont:
 
             rv.append(gl)
 
-        hb_buffer_destroy(hb)
-
         return rv
 
     def bounds(self, glyphs, bounds):
@@ -898,3 +1039,72 @@ cdef class HBFont:
                         line[1] = Sg
                         line[2] = Sb
                         line[3] = Sa
+
+    def draw_sdf(self, pysurf, float xo, int yo, color, list glyphs, int spread):
+        """
+        Draws a list of glyphs to surf as a signed distance field, with the
+        baseline starting at x, y. The field of each glyph extends `spread`
+        pixels past its bitmap, and the glyphs are drawn offset by -spread.
+
+        Returns False if one of the glyphs is a color bitmap, which can't
+        be drawn this way, and True otherwise.
+        """
+
+        cdef SDL_Surface *surf
+        cdef unsigned char r, g, b
+        cdef Glyph glyph
+        cdef glyph_cache *cache
+        cdef int x, y, left, top, width, rows
+        cdef bytes field
+        cdef int index
+
+        r, g, b = color[:3]
+
+        self.setup()
+
+        surf = PySurface_AsSurface(pysurf)
+
+        for glyph in glyphs:
+
+            if glyph.split == SPLIT_INSTEAD:
+                continue
+
+            if not glyph.draw:
+                continue
+
+            x = <int> (glyph.x + xo + glyph.x_offset)
+            y = <int> (glyph.y + yo + glyph.y_offset)
+
+            index = glyph.glyph
+
+            entry = self.sdf_cache.get((index, spread), None)
+
+            if entry is None:
+
+                cache = self.get_glyph(index)
+
+                if cache.bitmap.pixel_mode == FT_PIXEL_MODE_BGRA:
+                    entry = False
+                else:
+                    entry = (
+                        cache.bitmap_left - spread,
+                        cache.bitmap_top + spread,
+                        cache.bitmap.width + 2 * spread,
+                        cache.bitmap.rows + 2 * spread,
+                        distance_field(cache.bitmap.buffer, cache.bitmap.pitch, cache.bitmap.width, cache.bitmap.rows, spread),
+                        )
+
+                self.sdf_cache[(index, spread)] = entry
+
+            if entry is False:
+                return False
+
+            left, top, width, rows, field = entry
+
+            draw_distance_field(
+                <unsigned char *> surf.pixels, surf.pitch, surf.w, surf.h,
+                <int> (x + .5) + left, y - top,
+                <unsigned char *> <char *> field, width, rows,
+                r, g, b)
+
+        return True
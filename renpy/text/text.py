@@ -67,6 +67,31 @@ class Blit(object):
         return "<Blit ({0}, {1}, {2}, {3}) {4}>".format(self.x, self.y, self.w, self.h, self.alpha)
 
 
+def sdf_render(width, height, outline, color, spread):
+    """
+    Returns a Render that draws the signed distance field textures blitted
+    into it as text, expanded by `outline` pixels and in `color`, or in the
+    color of the text if `color` is None.
+    """
+
+    rv = renpy.display.render.Render(width, height)
+    rv.add_shader("renpy.sdf_text")
+
+    rv.add_uniform("u_renpy_sdf_threshold", 0.5 - outline * 0.5 / spread)
+    rv.add_uniform("u_renpy_sdf_smoothing", 0.25 / spread)
+
+    if color is None:
+        rv.add_uniform("u_renpy_sdf_color", (0.0, 0.0, 0.0, 0.0))
+        rv.add_uniform("u_renpy_sdf_use_color", 0.0)
+    else:
+        r, g, b, a = color
+        a = a / 255.0
+        rv.add_uniform("u_renpy_sdf_color", (r / 255.0 * a, g / 255.0 * a, b / 255.0 * a, a))
+        rv.add_uniform("u_renpy_sdf_use_color", 1.0)
+
+    return rv
+
+
 def outline_blits(blits, outline):
     """
     Given a list of blits, adjusts it for the given outline size. That means
@@ -157,6 +182,11 @@ class DrawInfo(object):
     `displayable_blits`
         If not none, this is a list of (displayable, xo, yo) tuples. The draw
         method adds displayable blits to this list when this is not None.
+
+    `sdf`
+        If not 0, the text is drawn as a signed distance field with this
+        spread, and the draw method sets `sdf_failed` to True if it can't
+        be.
     """
 
     # No implementation, this is set up in the layout object.
@@ -165,6 +195,8 @@ class DrawInfo(object):
     override_color = None # type: Optional[tuple[int, int, int, int]]
     outline = 0 # type: float
     displayable_blits = None # type: Optional[list[tuple[renpy.display.displayable.Displayable, int, int]]]
+    sdf = 0 # type: int
+    sdf_failed = False
 
 class TextSegment(object):
     """
@@ -293,6 +325,15 @@ class TextSegment(object):
             black_color = self.black_color
 
         fo = font.get_font(self.font, self.size, self.bold, self.italic, di.outline, self.antialias, self.vertical, self.hinting, layout.oversample, self.shaper)
+
+        if di.sdf:
+            draw_sdf = getattr(fo, "draw_sdf", None)
+
+            if (draw_sdf is None) or not draw_sdf(di.surface, xo, yo, color, glyphs, di.sdf):
+                di.sdf_failed = True
+
+            return
+
         fo.draw(di.surface, xo, yo, color, glyphs, self.underline, self.strikethrough, black_color)
 
     def assign_times(self, gt, glyphs):
@@ -838,6 +879,13 @@ class Layout(object):
 
         di = DrawInfo()
 
+        # The spread of the distance field the text is drawn as, or 0 if
+        # it's drawn as a texture per outline.
+        self.sdf = self.figure_sdf(par_seg_glyphs)
+
+        if self.sdf and not self.draw_sdf(par_seg_glyphs, di, sw, sh, style):
+            self.sdf = 0
+
         for o, color, _xo, _yo in self.outlines:
             key = (o, color)
 
@@ -926,6 +974,90 @@ class Layout(object):
                 renpy.display.to_log.write("     Available: (%d, %d) Laid-out: (%d, %d)", width, height, sw, sh)
                 renpy.display.to_log.write("     Text: %r", text.text)
 
+    def figure_sdf(self, par_seg_glyphs):
+        """
+        Returns the spread of the signed distance field this text should be
+        drawn as, or 0 if it should be drawn as a texture per outline.
+        """
+
+        if not renpy.config.text_sdf:
+            return 0
+
+        if not renpy.display.render.models:
+            return 0
+
+        if renpy.game.preferences.high_contrast or renpy.config.debug_text_alignment:
+            return 0
+
+        # The distance field only has the color of the text, so segments
+        # with their own outline colors or a translucent color, and lines
+        # that aren't glyphs, need a texture per outline.
+        for ts, _glyphs in par_seg_glyphs:
+
+            if not isinstance(ts, TextSegment):
+                continue
+
+            if ts.outline_color is not None or ts.underline or ts.strikethrough:
+                return 0
+
+            if (ts.color is None) or (ts.color[3] != 255):
+                return 0
+
+        return max(renpy.config.text_sdf_spread, max(o for o, _color, _xo, _yo in self.outlines) + 2)
+
+    def draw_sdf(self, par_seg_glyphs, di, sw, sh, style):
+        """
+        Draws the text once, as a signed distance field that the text and
+        each of its outlines and shadows are rendered from by the
+        renpy.sdf_text shader. Returns False if a font can't draw
+        distance fields.
+        """
+
+        spread = self.sdf
+
+        tw = int(sw + 2 * spread)
+        th = int(sh + 2 * spread)
+
+        # If not a multiple of 32, round up.
+        tw = (tw | 0x1f) + 1 if (tw & 0x1f) else tw
+        th = (th | 0x1f) + 1 if (th & 0x1f) else th
+
+        surf = renpy.display.pgrender.surface((tw, th), True)
+
+        self.displayable_blits = [ ]
+
+        di.surface = surf
+        di.override_color = None
+        di.outline = 0
+        di.displayable_blits = self.displayable_blits
+        di.sdf = spread
+        di.sdf_failed = False
+
+        for ts, glyphs in par_seg_glyphs:
+            if ts is self.end_segment:
+                break
+
+            ts.draw(glyphs, di, self.add_left + spread, self.add_top + spread, self)
+
+            if di.sdf_failed:
+                break
+
+        di.sdf = 0
+
+        if di.sdf_failed:
+            return False
+
+        renpy.display.draw.mutated_surface(surf)
+        tex = renpy.display.draw.load_texture(surf, properties={
+            "mipmap" : renpy.config.mipmap_text if (style.mipmap is None) else style.mipmap,
+            "premultiplied" : True,
+            })
+
+        for o, color, _xo, _yo in self.outlines:
+            self.textures[o, color] = tex
+
+        return True
+
     def make_alignment_grid(self, surf):
         w, h = surf.get_size()
 
@@ -2295,8 +2427,21 @@ class Text(renpy.display.displayable.Displayable):
         for o, color, xo, yo in layout.outlines:
             tex = layout.textures[o, color]
 
-            if o:
-                oblits = outline_blits(blits, o)
+            pad = o
+
+            # The distance field is padded by its spread, rather than by the
+            # size of the outline, so the blits are shifted into it. They're
+            # only widened by the outline, so slow text doesn't show part
+            # of the next glyph.
+            if layout.sdf:
+                shift = layout.sdf - o
+                target = sdf_render(w, h, o, color, layout.sdf)
+            else:
+                shift = 0
+                target = None
+
+            if pad:
+                oblits = outline_blits(blits, pad)
             else:
                 oblits = blits
 
@@ -2327,11 +2472,11 @@ class Text(renpy.display.displayable.Displayable):
                 # Expand the blits and offset them as necessary.
                 if b.right:
                     b_w += layout.add_right
-                    b_w += o
+                    b_w += pad
 
                 if b.bottom:
                     b_h += layout.add_bottom
-                    b_h += o
+                    b_h += pad
 
                 if b.left:
                     b_w += layout.add_left
@@ -2344,11 +2489,25 @@ class Text(renpy.display.displayable.Displayable):
                     b_y += layout.add_top
 
                 # Blit.
-                rv.absolute_blit(
-                    tex.subsurface((b_x, b_y, b_w, b_h)),
-                    layout.unscale_pair(b_x + xo + layout.xoffset - o - layout.add_left,
-                                        b_y + yo + layout.yoffset - o - layout.add_top)
-                    )
+                if target is not None:
+
+                    # The shader render is a child of rv, so its children
+                    # are placed in drawable pixels.
+                    target.absolute_blit(
+                        tex.subsurface((b_x + shift, b_y + shift, b_w, b_h)),
+                        (b_x + xo + layout.xoffset - pad - layout.add_left,
+                         b_y + yo + layout.yoffset - pad - layout.add_top)
+                        )
+
+                else:
+                    rv.absolute_blit(
+                        tex.subsurface((b_x, b_y, b_w, b_h)),
+                        layout.unscale_pair(b_x + xo + layout.xoffset - pad - layout.add_left,
+                                            b_y + yo + layout.yoffset - pad - layout.add_top)
+                        )
+
+            if target is not None:
+                rv.blit(target, (0, 0))
 
         # Blit displayables.
         if layout.displayable_blits:
@@ -94,3 +94,7 @@ cdef class Line:
 
         # Are we the last line in a paragraph?
         public bint eop
+
+
+cdef bytes distance_field(unsigned char *buffer, int pitch, int width, int rows, int spread)
+cdef void draw_distance_field(unsigned char *pixels, int pitch, int surf_width, int surf_height, int bmx, int bmy, unsigned char *sdf, int width, int rows, unsigned char r, unsigned char g, unsigned char b) nogil
@@ -22,6 +22,11 @@
 from __future__ import print_function
 from builtins import chr
 
+cimport cython
+
+from libc.stdlib cimport malloc, free
+from libc.math cimport sqrt
+
 import renpy
 
 include "linebreak.pxi"
@@ -86,28 +91,57 @@ TAG=2
 PARAGRAPH=3
 DISPLAYABLE=4
 
+cdef int finish_text(list rv, unicode s, Py_ssize_t start, Py_ssize_t end, list pieces) except -1:
+    """
+    Adds the text run from `start` to `end` of `s` to `rv`. If `pieces` is
+    not None, it's a list of the earlier parts of the run, that were
+    separated by escaped braces.
+    """
+
+    cdef unicode text
+
+    if pieces is not None:
+        pieces.append(s[start:end])
+        text = u"".join(pieces)
+    elif start < end:
+        text = s[start:end]
+    else:
+        return 0
+
+    if not text:
+        return 0
+
+    if (u"【" in text) and renpy.config.lenticular_bracket_ruby:
+        rv.extend(lenticular_bracket_ruby(text))
+    else:
+        rv.append((TEXT, text))
+
+    return 0
+
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
 def tokenize(unicode s):
     """
     This tokenizes a unicode string into text tags and tokens. It returns a list
     of pairs, where each pair begins with TEXT, TAG or PARAGRAPH, and then has
     the contents of the text run or tag.
-    """
 
-    cdef int TEXT_STATE = 1
-    cdef int LEFT_BRACE_STATE = 2
-    cdef int TAG_STATE = 3
-    cdef int state = TEXT_STATE
+    The string is scanned once, and each token is a slice of it, except for
+    text runs containing escaped braces, which are joined together.
+    """
 
+    cdef Py_ssize_t length = len(s)
+    cdef Py_ssize_t i = 0
+    cdef Py_ssize_t start = 0
+    cdef Py_ssize_t tag_start
     cdef Py_UCS4 c
-    cdef unicode buf = u''
 
-    cdef list rv = [ ]
+    # The earlier parts of the current text run, if it contains escaped
+    # braces.
+    cdef list pieces = None
 
-    def finish_text():
-        if  ("【" in buf) and renpy.config.lenticular_bracket_ruby:
-            rv.extend(lenticular_bracket_ruby(buf))
-        else:
-            rv.append((TEXT, buf))
+    cdef list rv = [ ]
 
     if not s:
         return [ ]
@@ -116,68 +150,69 @@ def tokenize(unicode s):
         rv.append((TEXT, s))
         return rv
 
-    for c in s:
+    while i < length:
 
-        if state == TEXT_STATE:
+        c = s[i]
 
-            if c == u'\n':
-                if buf:
-                    finish_text()
+        if c == u'\n':
+            finish_text(rv, s, start, i, pieces)
+            pieces = None
 
-                rv.append((PARAGRAPH, u''))
-                buf = u''
+            rv.append((PARAGRAPH, u''))
 
-                continue
+            i += 1
+            start = i
 
-            elif c == u'{':
-                state = LEFT_BRACE_STATE
-                continue
+        elif c == u'{':
 
-            else:
-                buf += c
-                continue
+            if i + 1 >= length:
+                raise Exception("Open text tag at end of string {0!r}.".format(s))
+
+            c = s[i + 1]
 
-        elif state == LEFT_BRACE_STATE:
             if c == u'{':
-                buf += c
-                state = TEXT_STATE
-                continue
+
+                # Keep the first brace as part of the text.
+                if pieces is None:
+                    pieces = [ ]
+
+                pieces.append(s[start:i + 1])
+
+                i += 2
+                start = i
 
             elif c == u'}':
                 raise Exception("Empty text tag in {0!r}.".format(s))
 
             else:
-                if buf:
-                    finish_text()
+                finish_text(rv, s, start, i, pieces)
+                pieces = None
 
-                buf = c
-                state = TAG_STATE
-                continue
+                tag_start = i + 1
+                i = tag_start
 
-        elif state == TAG_STATE:
+                while i < length and s[i] != u'}':
+                    i += 1
 
-            if c == u'}':
-                rv.append((TAG, buf))
-                buf = u''
-                state = TEXT_STATE
-                continue
+                if i >= length:
+                    raise Exception("Open text tag at end of string {0!r}.".format(s))
 
-            else:
-                buf += c
+                rv.append((TAG, s[tag_start:i]))
 
-    if state != TEXT_STATE:
-        raise Exception("Open text tag at end of string {0!r}.".format(s))
+                i += 1
+                start = i
 
-    if buf:
-        finish_text()
+        else:
+            i += 1
 
-    if s == "":
-        print(rv)
+    finish_text(rv, s, start, length, pieces)
 
     return rv
 
 
-def lenticular_bracket_ruby(s):
+@cython.boundscheck(False)
+@cython.wraparound(False)
+def lenticular_bracket_ruby(unicode s):
     """
     This tokenizes text that may contain lenticular bracket ruby. It searches
     for 【東京｜とうきょう】 and converts it to the equivalent of
@@ -189,76 +224,69 @@ def lenticular_bracket_ruby(s):
     cdef int RIGHT_STATE = 3
     cdef int state = TEXT_STATE
 
+    cdef Py_ssize_t length = len(s)
+    cdef Py_ssize_t i
     cdef Py_UCS4 c
-    cdef unicode buf = u''
+
+    # The start of the text that's been seen in the current state.
+    cdef Py_ssize_t start = 0
 
     cdef list rv = [ ]
 
-    for c in s:
+    for i in range(length):
+
+        c = s[i]
 
         if state == TEXT_STATE:
 
             if c == u'【':
-                if buf:
-                    rv.append((TEXT, buf))
+                if start < i:
+                    rv.append((TEXT, s[start:i]))
 
-                buf = u''
+                start = i + 1
                 state = LEFT_STATE
-                continue
-
-            else:
-                buf += c
-                continue
 
         elif state == LEFT_STATE:
-            if c == u'【' and not buf:
-                buf += c
+
+            # A doubled bracket is a literal bracket, starting a text run.
+            if c == u'【' and start == i:
+                start = i
                 state = TEXT_STATE
-                continue
 
             elif c == u'】':
-                rv.append((TEXT, u'【' + buf + u'】'))
-                buf = u''
+                rv.append((TEXT, s[start - 1:i + 1]))
+                start = i + 1
                 state = TEXT_STATE
-                continue
 
             elif c == u'｜' or c == u'|':
                 rv.append((TAG, "rb"))
-                rv.append((TEXT, buf))
+                rv.append((TEXT, s[start:i]))
                 rv.append((TAG, "/rb"))
 
-                buf = u''
+                start = i + 1
                 state = RIGHT_STATE
-                continue
-
-            else:
-                buf += c
-                continue
 
         elif state == RIGHT_STATE:
 
             if c == u'】':
                 rv.append((TAG, "rt"))
-                rv.append((TEXT, buf))
+                rv.append((TEXT, s[start:i]))
                 rv.append((TAG, "/rt"))
-                buf = u''
-                state = TEXT_STATE
-                continue
 
-            else:
-                buf += c
+                start = i + 1
+                state = TEXT_STATE
 
-    if buf:
+    if start < length:
 
         if state == TEXT_STATE:
-            rv.append((TEXT, buf))
+            rv.append((TEXT, s[start:]))
 
         elif state == LEFT_STATE:
-            rv.append((TEXT, u'【' + buf))
+            rv.append((TEXT, s[start - 1:]))
 
         elif state == RIGHT_STATE:
             rv.append((TAG, "rt"))
-            rv.append((TEXT, buf))
+            rv.append((TEXT, s[start:]))
             rv.append((TAG, "/rt"))
 
     return rv
@@ -1139,3 +1167,192 @@ def offset_glyphs(list glyphs, int x, int y):
     for g in glyphs:
         g.x += x
         g.y += y
+
+
+################################################################################
+# Signed distance fields.
+
+# A distance larger than any in a glyph.
+DEF EDT_INF = 1e20
+
+
+cdef void edt_1d(double *f, double *d, int *v, double *z, int n) nogil:
+    """
+    Computes the one-dimensional squared euclidean distance transform of
+    `f` into `d`, using the algorithm of Felzenszwalb and Huttenlocher.
+    `v` and `z` are scratch arrays of n and n + 1 elements.
+    """
+
+    cdef int k = 0
+    cdef int q
+    cdef double s
+
+    v[0] = 0
+    z[0] = -EDT_INF
+    z[1] = EDT_INF
+
+    for q in range(1, n):
+
+        s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2 * q - 2 * v[k])
+
+        # As z[0] is -EDT_INF, this never takes k below 0.
+        while s <= z[k]:
+            k -= 1
+            s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2 * q - 2 * v[k])
+
+        k += 1
+        v[k] = q
+        z[k] = s
+        z[k + 1] = EDT_INF
+
+    k = 0
+
+    for q in range(n):
+        while z[k + 1] < q:
+            k += 1
+
+        d[q] = (q - v[k]) * (q - v[k]) + f[v[k]]
+
+
+cdef void edt_2d(double *grid, int width, int height, double *f, double *d, int *v, double *z) nogil:
+    """
+    Computes the squared euclidean distance transform of `grid` in place.
+    The scratch arrays must have max(width, height) (+ 1 for z) elements.
+    """
+
+    cdef int x, y
+
+    for x in range(width):
+        for y in range(height):
+            f[y] = grid[y * width + x]
+
+        edt_1d(f, d, v, z, height)
+
+        for y in range(height):
+            grid[y * width + x] = d[y]
+
+    for y in range(height):
+        edt_1d(grid + y * width, d, v, z, width)
+
+        for x in range(width):
+            grid[y * width + x] = d[x]
+
+
+cdef bytes distance_field(unsigned char *buffer, int pitch, int width, int rows, int spread):
+    """
+    Given an 8-bit coverage bitmap, returns a signed distance field of it
+    as a bytes object, (width + 2 * spread) by (rows + 2 * spread) pixels.
+    A value of 128 is on the edge of the glyph, larger values are inside,
+    and the values reach 0 and 255 `spread` pixels from the edge.
+    """
+
+    cdef int w = width + 2 * spread
+    cdef int h = rows + 2 * spread
+    cdef int n = max(w, h)
+    cdef int x, y, i
+    cdef int c
+    cdef double sd, value
+
+    cdef double *outside = <double *> malloc(w * h * sizeof(double))
+    cdef double *inside = <double *> malloc(w * h * sizeof(double))
+    cdef double *f = <double *> malloc(n * sizeof(double))
+    cdef double *d = <double *> malloc(n * sizeof(double))
+    cdef double *z = <double *> malloc((n + 1) * sizeof(double))
+    cdef int *v = <int *> malloc(n * sizeof(int))
+    cdef unsigned char *coverage = <unsigned char *> malloc(w * h)
+
+    rv = bytearray(w * h)
+
+    try:
+
+        with nogil:
+
+            for y in range(h):
+                for x in range(w):
+
+                    if (spread <= x < spread + width) and (spread <= y < spread + rows):
+                        c = buffer[(y - spread) * pitch + (x - spread)]
+                    else:
+                        c = 0
+
+                    i = y * w + x
+                    coverage[i] = c
+
+                    if c >= 128:
+                        outside[i] = 0
+                        inside[i] = EDT_INF
+                    else:
+                        outside[i] = EDT_INF
+                        inside[i] = 0
+
+            edt_2d(outside, w, h, f, d, v, z)
+            edt_2d(inside, w, h, f, d, v, z)
+
+        for i in range(w * h):
+
+            c = coverage[i]
+
+            # Pixels on the edge use their coverage, which is more precise
+            # than the distance between pixel centers.
+            if 0 < c < 255:
+                sd = 0.5 - c / 255.0
+            elif c:
+                sd = 0.5 - sqrt(inside[i])
+            else:
+                sd = sqrt(outside[i]) - 0.5
+
+            value = 127.5 - sd * 127.5 / spread
+
+            if value < 0:
+                value = 0
+            elif value > 255:
+                value = 255
+
+            rv[i] = <int> (value + .5)
+
+    finally:
+        free(outside)
+        free(inside)
+        free(f)
+        free(d)
+        free(z)
+        free(v)
+        free(coverage)
+
+    return bytes(rv)
+
+
+cdef void draw_distance_field(unsigned char *pixels, int pitch, int surf_width, int surf_height, int bmx, int bmy, unsigned char *sdf, int width, int rows, unsigned char r, unsigned char g, unsigned char b) nogil:
+    """
+    Draws a glyph's distance field into an RGBA surface, with the field in
+    alpha and the color of the glyph in RGB. Where glyphs overlap, the
+    larger value - the one closer to or further inside a glyph - wins.
+    """
+
+    cdef int x, y, sx, sy
+    cdef unsigned char *line
+    cdef unsigned char value
+
+    for y in range(rows):
+
+        sy = bmy + y
+
+        if sy < 0 or sy >= surf_height:
+            continue
+
+        line = pixels + sy * pitch
+
+        for x in range(width):
+
+            sx = bmx + x
+
+            if sx < 0 or sx >= surf_width:
+                continue
+
+            value = sdf[y * width + x]
+
+            if value > line[sx * 4 + 3]:
+                line[sx * 4] = r
+                line[sx * 4 + 1] = g
+                line[sx * 4 + 2] = b
+                line[sx * 4 + 3] = value
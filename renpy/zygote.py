@@ -0,0 +1,607 @@
+# Copyright 2004-2023 Tom Rothamel <pytom@bishoujo.us>
+#
+# Permission is hereby granted, free of charge, to any person
+# obtaining a copy of this software and associated documentation files
+# (the "Software"), to deal in the Software without restriction,
+# including without limitation the rights to use, copy, modify, merge,
+# publish, distribute, sublicense, and/or sell copies of the Software,
+# and to permit persons to whom the Software is furnished to do so,
+# subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be
+# included in all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+# EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+# NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+# LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+# OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+# WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+# This implements the zygote, a warm-start server for Linux. When Ren'Py is
+# run with --zygote, it loads the game and runs the init code, then waits
+# on a unix socket rather than starting the game. Later launches of the same
+# game connect to the socket, and the zygote forks a child that takes over
+# their standard input and output, arguments, environment, and working
+# directory, and then starts the game as if it had been launched normally.
+#
+# The launching process waits for the child to exit, and exits with its
+# status. If the script changes, the zygote tells the launching process
+# to start normally, and then restarts itself to load the new script.
+
+from __future__ import division, absolute_import, with_statement, print_function, unicode_literals
+from renpy.compat import PY2, basestring, bchr, bord, chr, open, pystr, range, round, str, tobytes, unicode # *
+
+import array
+import hashlib
+import json
+import os
+import random
+import select
+import signal
+import socket
+import stat
+import struct
+import sys
+import tempfile
+import threading
+
+import renpy
+
+# Messages from the zygote to the launching process. Each is a byte,
+# followed by a 4-byte integer.
+MESSAGE = struct.Struct("!ci")
+
+# The child has been forked, with the given pid.
+PID = b"P"
+
+# The child has exited, with the given status.
+EXIT = b"X"
+
+# The zygote can't run this launch, which should start normally.
+DECLINE = b"D"
+
+# The file extensions that, if changed, make the zygote stale.
+SCRIPT_EXTENSIONS = (".rpy", ".rpyc", ".rpym", ".rpymc", ".rpa", ".py")
+
+# The bootstrap arguments that must match between the zygote and a launch
+# for the zygote to run it.
+MATCHING_ARGUMENTS = ("savedir", "compile", "safe_mode", "lint", "errors_in_editor")
+
+
+def supported():
+    """
+    Returns true if the zygote can be used on this platform.
+    """
+
+    if PY2 or not renpy.linux:
+        return False
+
+    return hasattr(socket, "AF_UNIX") and hasattr(socket.socket, "sendmsg")
+
+
+def socket_dir(create=False):
+    """
+    Returns the directory the zygote sockets are placed in, creating it if
+    `create` is true. Returns None if the directory doesn't exist, or could
+    be reached by a user other than this one.
+    """
+
+    runtime = os.environ.get("XDG_RUNTIME_DIR", None)
+
+    if runtime:
+        rv = os.path.join(runtime, "renpy-zygote")
+    else:
+        rv = os.path.join(tempfile.gettempdir(), "renpy-zygote-{}".format(os.getuid()))
+
+    if create:
+        try:
+            os.mkdir(rv, 0o700)
+        except OSError:
+            pass
+
+    try:
+        st = os.lstat(rv)
+    except OSError:
+        return None
+
+    if not stat.S_ISDIR(st.st_mode):
+        return None
+
+    if st.st_uid != os.getuid():
+        return None
+
+    if st.st_mode & 0o077:
+        return None
+
+    return rv
+
+
+def socket_path(basedir, create=False):
+    """
+    Returns the path of the socket the zygote for `basedir` listens on, or
+    None if there is no private directory to place it in.
+    """
+
+    d = socket_dir(create)
+
+    if d is None:
+        return None
+
+    digest = hashlib.md5(os.path.abspath(basedir).encode("utf-8")).hexdigest()[:16]
+    return os.path.join(d, "{}.sock".format(digest))
+
+
+def peer_uid(sock):
+    """
+    Returns the uid of the process on the other end of the unix socket
+    `sock`.
+    """
+
+    creds = sock.getsockopt(socket.SOL_SOCKET, socket.SO_PEERCRED, struct.calcsize("3i"))
+    _pid, uid, _gid = struct.unpack("3i", creds)
+    return uid
+
+
+def receive_exactly(sock, size):
+    rv = b""
+
+    while len(rv) < size:
+        data = sock.recv(size - len(rv))
+
+        if not data:
+            raise EOFError()
+
+        rv += data
+
+    return rv
+
+
+################################################################################
+# Client.
+
+def launch(basedir):
+    """
+    Called during bootstrap. If a zygote is running for `basedir`, asks it
+    to run this launch, and exits with the status of the child it forks.
+    Returns if no zygote is running, or if it declines the launch.
+
+    This only does anything when the RENPY_ZYGOTE environment variable
+    is set.
+    """
+
+    if not supported():
+        return
+
+    if "RENPY_ZYGOTE" not in os.environ:
+        return
+
+    path = socket_path(basedir)
+
+    if path is None:
+        return
+
+    try:
+        st = os.lstat(path)
+    except OSError:
+        return
+
+    if not stat.S_ISSOCK(st.st_mode) or (st.st_uid != os.getuid()):
+        return
+
+    sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+
+    try:
+        sock.connect(path)
+
+        # Only hand our file descriptors and environment to a zygote run
+        # by this user.
+        if peer_uid(sock) != os.getuid():
+            sock.close()
+            return
+
+    except socket.error:
+        sock.close()
+        return
+
+    request = json.dumps({
+        "argv" : sys.argv,
+        "cwd" : os.getcwd(),
+        "env" : dict(os.environ),
+        }).encode("utf-8")
+
+    fds = array.array("i", [ 0, 1, 2 ])
+
+    pid = None
+
+    try:
+        sock.sendmsg([ struct.pack("!i", len(request)) ], [ (socket.SOL_SOCKET, socket.SCM_RIGHTS, fds.tobytes()) ])
+        sock.sendall(request)
+
+        while True:
+            kind, value = MESSAGE.unpack(receive_exactly(sock, MESSAGE.size))
+
+            if kind == DECLINE:
+                return
+
+            elif kind == PID:
+                pid = value
+                forward_signals(pid)
+
+            elif kind == EXIT:
+                sys.exit(value)
+
+    except (EOFError, socket.error):
+
+        # If the zygote went away before the child was forked, start
+        # normally. Otherwise, the launch has failed.
+        if pid is None:
+            return
+
+        sys.exit(1)
+
+    finally:
+        sock.close()
+
+
+def forward_signals(pid):
+    """
+    Forwards the signals the launching process gets to the child.
+    """
+
+    def handler(signum, frame):
+        try:
+            os.kill(pid, signum)
+        except OSError:
+            pass
+
+    for i in (signal.SIGINT, signal.SIGTERM, signal.SIGHUP):
+        signal.signal(i, handler)
+
+
+################################################################################
+# Server.
+
+def script_signature():
+    """
+    Returns a signature of the script and python files in the game and
+    common directories, that changes when any of them changes.
+    """
+
+    rv = [ ]
+
+    for d in (renpy.config.gamedir, renpy.config.commondir):
+
+        if not d:
+            continue
+
+        for root, dirs, files in os.walk(d):
+            dirs.sort()
+
+            for fn in sorted(files):
+                if not fn.endswith(SCRIPT_EXTENSIONS):
+                    continue
+
+                try:
+                    st = os.stat(os.path.join(root, fn))
+                except OSError:
+                    continue
+
+                rv.append((root, fn, st.st_mtime_ns, st.st_size))
+
+    return rv
+
+
+def parse_arguments(argv, cwd):
+    """
+    Parses the bootstrap arguments of a launch with `argv`, started in
+    `cwd`.
+    """
+
+    old_argv = sys.argv
+    old_cwd = os.getcwd()
+
+    try:
+        sys.argv = argv
+        os.chdir(cwd)
+
+        args = renpy.arguments.bootstrap()
+
+        if args.basedir:
+            args.basedir = os.path.abspath(args.basedir)
+
+        if args.savedir:
+            args.savedir = os.path.abspath(args.savedir)
+
+        if args.startup_profile:
+            args.startup_profile = os.path.abspath(args.startup_profile)
+
+        return args
+
+    finally:
+        sys.argv = old_argv
+        os.chdir(old_cwd)
+
+
+def matches(args, mine):
+    """
+    Returns true if a launch with the bootstrap arguments `args` can be
+    run by a zygote started with the bootstrap arguments `mine`.
+    """
+
+    for i in MATCHING_ARGUMENTS:
+        if getattr(args, i, None) != getattr(mine, i, None):
+            return False
+
+    if args.zygote:
+        return False
+
+    return True
+
+
+def serve():
+    """
+    Called by renpy.main.main once the game has been loaded and initialized,
+    but before the display has been created. This listens for launches, and
+    returns only in a forked child.
+    """
+
+    path = socket_path(renpy.config.basedir, create=True)
+
+    if path is None:
+        raise Exception("The zygote could not create a directory for its socket that only this user can access.")
+
+    signature = script_signature()
+    mine = parse_arguments(sys.argv, os.getcwd())
+
+    # True if the script has changed, and the zygote should restart once
+    # its children have exited.
+    stale = False
+
+    try:
+        os.unlink(path)
+    except OSError:
+        pass
+
+    listener = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+
+    old_umask = os.umask(0o077)
+
+    try:
+        listener.bind(path)
+    finally:
+        os.umask(old_umask)
+
+    listener.listen(16)
+
+    def stop(signum, frame):
+        try:
+            os.unlink(path)
+        except OSError:
+            pass
+
+        os._exit(0)
+
+    old_handlers = { }
+
+    for i in (signal.SIGINT, signal.SIGTERM, signal.SIGHUP):
+        old_handlers[i] = signal.signal(i, stop)
+
+    renpy.display.log.write("Zygote listening on %s.", path)
+    print("Zygote listening on {}.".format(path))
+    sys.stdout.flush()
+
+    # A map from the pid of a child to the connection to its launching
+    # process.
+    children = { }
+
+    while True:
+
+        readable, _, _ = select.select([ listener ], [ ], [ ], 0.25)
+
+        reap(children)
+
+        if stale and not children:
+            restart(listener, path)
+
+        if not readable:
+            continue
+
+        try:
+            conn, _ = listener.accept()
+        except socket.error:
+            continue
+
+        # Only run launches from this user.
+        try:
+            uid = peer_uid(conn)
+        except socket.error:
+            uid = None
+
+        if uid != os.getuid():
+            renpy.display.log.write("Zygote refused a launch from uid %r.", uid)
+            conn.close()
+            continue
+
+        try:
+            request, fds = receive_request(conn)
+        except Exception as e:
+            renpy.display.log.write("Zygote could not receive a launch: %r", e)
+            continue
+
+        try:
+            args = parse_arguments(request["argv"], request["cwd"])
+        except BaseException:
+            args = None
+
+        if stale or (script_signature() != signature):
+            stale = True
+
+        if stale or (args is None) or not matches(args, mine):
+            decline(conn, fds)
+            continue
+
+        pid = os.fork()
+
+        if pid:
+            for fd in fds:
+                os.close(fd)
+
+            children[pid] = conn
+            send(conn, PID, pid)
+
+            continue
+
+        # The child.
+        listener.close()
+        conn.close()
+
+        for i, fd in enumerate(fds):
+            os.dup2(fd, i)
+            os.close(fd)
+
+        for i, handler in old_handlers.items():
+            signal.signal(i, handler)
+
+        after_fork(request, args)
+
+        return
+
+
+def receive_request(conn):
+    """
+    Receives a launch request from `conn`. Returns the request, and the
+    file descriptors that should be used as stdin, stdout, and stderr.
+    """
+
+    fds = array.array("i")
+
+    data, ancdata, _flags, _addr = conn.recvmsg(4, socket.CMSG_SPACE(3 * fds.itemsize))
+
+    for level, kind, cmsg_data in ancdata:
+        if level == socket.SOL_SOCKET and kind == socket.SCM_RIGHTS:
+            fds.frombytes(cmsg_data[:len(cmsg_data) - (len(cmsg_data) % fds.itemsize)])
+
+    fds = list(fds)
+
+    try:
+        if len(fds) != 3:
+            raise Exception("Expected 3 file descriptors, got {}.".format(len(fds)))
+
+        if len(data) < 4:
+            data += receive_exactly(conn, 4 - len(data))
+
+        size, = struct.unpack("!i", data)
+        request = json.loads(receive_exactly(conn, size).decode("utf-8"))
+
+    except Exception:
+        for fd in fds:
+            os.close(fd)
+
+        conn.close()
+        raise
+
+    return request, fds
+
+
+def send(conn, kind, value):
+    try:
+        conn.sendall(MESSAGE.pack(kind, value))
+    except socket.error:
+        pass
+
+
+def decline(conn, fds):
+    """
+    Tells a launching process to start normally.
+    """
+
+    for fd in fds:
+        os.close(fd)
+
+    send(conn, DECLINE, 0)
+    conn.close()
+
+
+def reap(children):
+    """
+    Reports the status of exited children to their launching processes.
+    """
+
+    while children:
+
+        try:
+            pid, status = os.waitpid(-1, os.WNOHANG)
+        except ChildProcessError:
+            return
+
+        if not pid:
+            return
+
+        conn = children.pop(pid, None)
+
+        if conn is None:
+            continue
+
+        if os.WIFSIGNALED(status):
+            status = 128 + os.WTERMSIG(status)
+        else:
+            status = os.WEXITSTATUS(status)
+
+        send(conn, EXIT, status)
+        conn.close()
+
+
+def restart(listener, path):
+    """
+    Restarts the zygote, so it loads a changed script.
+    """
+
+    renpy.display.log.write("Zygote restarting, as the script has changed.")
+
+    listener.close()
+
+    try:
+        os.unlink(path)
+    except OSError:
+        pass
+
+    os.execv(sys.executable, [ sys.executable ] + sys.argv)
+
+
+def after_fork(request, args):
+    """
+    Sets up a forked child to run the launch given by `request`, with the
+    bootstrap arguments `args`.
+    """
+
+    os.chdir(request["cwd"])
+
+    os.environ.clear()
+    os.environ.update(request["env"])
+
+    sys.argv = request["argv"]
+
+    # Update the bootstrap arguments in place, so they survive an utter
+    # restart.
+    vars(renpy.game.args).update(vars(args))
+
+    if args.startup_profile:
+        renpy.startupprofile.start(args.startup_profile, args.startup_profile_quit)
+
+    # Don't share random state with the zygote or other children.
+    random.seed()
+    random.Random.seed(renpy.rollback.rng)
+
+    # Only the forking thread survives in the child, so threads started
+    # before the fork have to be recreated, along with locks they might
+    # have held.
+    renpy.loader.io_thread = None
+    renpy.loader.io_condition = threading.Condition()
+    renpy.loader.io_files.clear()
+    del renpy.loader.io_queue[:]
+
+    renpy.display.im.cache.after_fork()
+    renpy.display.im.zip_executor = None
+    renpy.savelocation.after_fork()
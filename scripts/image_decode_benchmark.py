@@ -0,0 +1,120 @@
+#!/usr/bin/env python3
+
+# Measures how quickly the images in a game are decoded, by the native
+# decoder in renpy.display.imagedecode and by pygame_sdl2. This must be run
+# using a Python with the Ren'Py and pygame_sdl2 modules built for it.
+
+from __future__ import print_function
+
+import argparse
+import concurrent.futures
+import io
+import pathlib
+import sys
+import time
+
+# The path to Ren'Py.
+RENPY = pathlib.Path(__file__).resolve().parent.parent
+
+sys.path.insert(0, str(RENPY))
+
+import pygame_sdl2 # type: ignore
+import renpy.display.imagedecode # type: ignore
+
+# The extensions of the images that are decoded.
+EXTENSIONS = { ".png", ".jpg", ".jpeg", ".webp" }
+
+
+def make_surface(size):
+    return pygame_sdl2.Surface(size, 0, 32, renpy.display.imagedecode.RGBA_MASKS)
+
+
+def native(fn, data):
+    rv = renpy.display.imagedecode.decode(data, make_surface)
+
+    if rv is None:
+        raise Exception("{} could not be decoded natively.".format(fn))
+
+    return rv
+
+
+def sdl(fn, data):
+    """
+    Decodes the image the way Ren'Py did without the native decoder: with
+    SDL_image, followed by a copy into an RGBA surface.
+    """
+
+    surf = pygame_sdl2.image.load(io.BytesIO(data), fn)
+
+    rv = make_surface(surf.get_size())
+    surf.set_alpha(None)
+    rv.blit(surf, (0, 0))
+
+    return rv
+
+
+def measure(decode, images, args):
+    """
+    Decodes each image `args.runs` times with `decode`, using `args.threads`
+    threads. Returns the best time taken to decode all the images, in
+    seconds.
+    """
+
+    best = None
+
+    with concurrent.futures.ThreadPoolExecutor(args.threads) as executor:
+
+        for _i in range(args.runs):
+            start = time.perf_counter()
+            list(executor.map(lambda i : decode(*i), images))
+            elapsed = time.perf_counter() - start
+
+            if (best is None) or (elapsed < best):
+                best = elapsed
+
+    return best
+
+
+def main():
+
+    ap = argparse.ArgumentParser(description="Reports how quickly the images in a game are decoded.")
+    ap.add_argument("game", nargs="?", default=str(RENPY / "tutorial"), help="The game whose images are decoded. Defaults to the tutorial.")
+    ap.add_argument("--runs", type=int, default=5, help="The number of times the images are decoded. The best time is reported.")
+    ap.add_argument("--threads", type=int, default=1, help="The number of threads the images are decoded in.")
+
+    args = ap.parse_args()
+
+    images = [ ]
+    pixels = 0
+
+    for fn in sorted(pathlib.Path(args.game).rglob("*")):
+
+        if fn.suffix.lower() not in EXTENSIONS:
+            continue
+
+        data = fn.read_bytes()
+
+        try:
+            surf = native(fn.name, data)
+        except Exception as e:
+            print(e)
+            continue
+
+        w, h = surf.get_size()
+        pixels += w * h
+
+        images.append((fn.name, data))
+
+    if not images:
+        print("No images were found in {}.".format(args.game))
+        return
+
+    print("{} images, {:.1f} megapixels, {} thread(s).".format(len(images), pixels / 1000000.0, args.threads))
+
+    for name, decode in [ ("native", native), ("sdl", sdl) ]:
+        elapsed = measure(decode, images, args)
+        print("    {:8s} {:8.1f} ms {:8.1f} megapixels/s".format(name, elapsed * 1000, pixels / elapsed / 1000000.0))
+
+
+if __name__ == "__main__":
+    main()
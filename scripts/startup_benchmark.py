@@ -0,0 +1,127 @@
+#!/usr/bin/env python3
+
+# Measures how long games take to start. Each game is run headlessly with
+# --startup-profile, once cold (with the game's cache directory removed) and
+# a number of times warm, and the time to the first frame is reported.
+
+from __future__ import print_function
+
+import argparse
+import json
+import os
+import pathlib
+import shutil
+import statistics
+import subprocess
+import sys
+import tempfile
+
+# The path to Ren'Py.
+RENPY = pathlib.Path(__file__).resolve().parent.parent
+
+# The games that are benchmarked by default.
+GAMES = [ "tutorial", "the_question" ]
+
+
+def run(game, args, savedir, trace):
+    """
+    Runs `game` until its first frame is drawn, and returns the events
+    in the startup trace it writes.
+    """
+
+    env = dict(os.environ)
+
+    if not args.display:
+        env["SDL_VIDEODRIVER"] = "dummy"
+        env["SDL_AUDIODRIVER"] = "dummy"
+
+    command = [
+        args.python,
+        str(RENPY / "renpy.py"),
+        str(game),
+        "--savedir", str(savedir),
+        "--startup-profile", str(trace),
+        "--startup-profile-quit",
+        ]
+
+    subprocess.run(command, env=env, check=True, timeout=args.timeout, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+
+    with open(trace) as f:
+        return json.load(f)["traceEvents"]
+
+
+def total(events):
+    """
+    Returns the (wall ms, cpu ms) of the whole of startup.
+    """
+
+    for e in events:
+        if e["name"] == "Startup":
+            return e["dur"] / 1000.0, e["args"]["cpu_ms"]
+
+    raise Exception("The trace does not contain a startup event.")
+
+
+def benchmark(game, args):
+
+    game = pathlib.Path(game)
+
+    if not game.is_absolute():
+        game = RENPY / game
+
+    tmp = pathlib.Path(tempfile.mkdtemp(prefix="renpy-startup-"))
+
+    try:
+        trace = tmp / "startup.json"
+        savedir = tmp / "saves"
+
+        shutil.rmtree(game / "game" / "cache", ignore_errors=True)
+
+        cold_events = run(game, args, savedir, trace)
+        cold = total(cold_events)
+
+        warm = [ total(run(game, args, savedir, trace)) for _i in range(args.runs) ]
+
+    finally:
+        shutil.rmtree(tmp, ignore_errors=True)
+
+    print("{}:".format(game.name))
+    print("    cold: {:8.1f} ms wall {:8.1f} ms cpu".format(*cold))
+
+    if warm:
+        wall = [ i[0] for i in warm ]
+        cpu = [ i[1] for i in warm ]
+
+        print("    warm: {:8.1f} ms wall {:8.1f} ms cpu (median of {}, best {:.1f} ms)".format(
+            statistics.median(wall), statistics.median(cpu), len(warm), min(wall)))
+
+    if args.phases:
+        print("    slowest phases when cold:")
+
+        phases = [ e for e in cold_events if e["name"] != "Startup" ]
+        phases.sort(key=lambda e : -e["dur"])
+
+        for e in phases[:args.phases]:
+            print("        {:40s} {:8.1f} ms".format(e["name"][:40], e["dur"] / 1000.0))
+
+    print()
+
+
+def main():
+
+    ap = argparse.ArgumentParser(description="Reports the cold and warm startup times of games.")
+    ap.add_argument("games", nargs="*", default=GAMES, help="The games to benchmark. Defaults to the tutorial and The Question.")
+    ap.add_argument("--runs", type=int, default=5, help="The number of warm runs of each game.")
+    ap.add_argument("--phases", type=int, default=10, help="The number of slow phases to list for each game.")
+    ap.add_argument("--python", default=sys.executable, help="The Python used to run Ren'Py.")
+    ap.add_argument("--timeout", type=float, default=300, help="The longest a single run may take, in seconds.")
+    ap.add_argument("--display", action="store_true", help="Use the real display and audio drivers, rather than dummy ones.")
+
+    args = ap.parse_args()
+
+    for game in args.games:
+        benchmark(game, args)
+
+
+if __name__ == "__main__":
+    main()
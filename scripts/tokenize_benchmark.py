@@ -0,0 +1,180 @@
+#!/usr/bin/env python3
+
+# Measures how quickly text is tokenized into text tags. A corpus of tagged
+# dialogue is built from the strings in games' scripts, and tokenized with
+# renpy.text.textsupport.tokenize. The results are checked against a simple
+# character-at-a-time tokenizer, which is also timed. This must be run
+# using a Python with the Ren'Py modules built for it.
+
+from __future__ import print_function
+
+import argparse
+import ast
+import pathlib
+import re
+import sys
+import time
+
+# The path to Ren'Py.
+RENPY = pathlib.Path(__file__).resolve().parent.parent
+
+sys.path.insert(0, str(RENPY))
+
+import renpy # type: ignore
+import renpy.config # type: ignore
+import renpy.text.textsupport as textsupport # type: ignore
+
+# The games whose strings are used by default.
+GAMES = [ "tutorial", "the_question" ]
+
+# Matches a double-quoted string in a script.
+STRING_RE = re.compile(r'"(?:[^"\\]|\\.)*"')
+
+
+def reference(s):
+    """
+    Tokenizes `s` one character at a time. This doesn't handle lenticular
+    bracket ruby, so the corpus doesn't use it.
+    """
+
+    rv = [ ]
+    buf = ""
+    state = "text"
+
+    for c in s:
+
+        if state == "text":
+            if c == "\n":
+                if buf:
+                    rv.append((textsupport.TEXT, buf))
+                rv.append((textsupport.PARAGRAPH, ""))
+                buf = ""
+            elif c == "{":
+                state = "brace"
+            else:
+                buf += c
+
+        elif state == "brace":
+            if c == "{":
+                buf += c
+                state = "text"
+            else:
+                if buf:
+                    rv.append((textsupport.TEXT, buf))
+                buf = c
+                state = "tag"
+
+        else:
+            if c == "}":
+                rv.append((textsupport.TAG, buf))
+                buf = ""
+                state = "text"
+            else:
+                buf += c
+
+    if buf:
+        rv.append((textsupport.TEXT, buf))
+
+    return rv
+
+
+def corpus(games):
+    """
+    Returns a list of the strings in the scripts of `games`, that contain
+    text tags or newlines.
+    """
+
+    rv = [ ]
+
+    for game in games:
+
+        game = pathlib.Path(game)
+
+        if not game.is_absolute():
+            game = RENPY / game
+
+        for fn in sorted(game.rglob("*.rpy")):
+            text = fn.read_text(encoding="utf-8", errors="replace")
+
+            for m in STRING_RE.finditer(text):
+                try:
+                    s = ast.literal_eval(m.group(0))
+                except Exception:
+                    continue
+
+                if ("{" not in s) and ("\n" not in s):
+                    continue
+
+                if "【" in s:
+                    continue
+
+                try:
+                    textsupport.tokenize(s)
+                except Exception:
+                    continue
+
+                rv.append(s)
+
+    return rv
+
+
+def measure(function, strings, runs):
+    """
+    Returns the best time, in seconds, that `function` takes to tokenize
+    all of `strings`.
+    """
+
+    best = None
+
+    for _i in range(runs):
+        start = time.perf_counter()
+
+        for s in strings:
+            function(s)
+
+        elapsed = time.perf_counter() - start
+
+        if (best is None) or (elapsed < best):
+            best = elapsed
+
+    return best
+
+
+def main():
+
+    ap = argparse.ArgumentParser(description="Reports how quickly tagged text is tokenized.")
+    ap.add_argument("games", nargs="*", default=GAMES, help="The games the strings are taken from. Defaults to the tutorial and The Question.")
+    ap.add_argument("--runs", type=int, default=5, help="The number of times the corpus is tokenized. The best time is reported.")
+    ap.add_argument("--pages", type=int, default=50, help="The number of strings joined into each NVL-page-sized string.")
+
+    args = ap.parse_args()
+
+    renpy.config.lenticular_bracket_ruby = False
+
+    strings = corpus(args.games)
+
+    if not strings:
+        print("No tagged strings were found.")
+        return
+
+    # Long strings, like NVL pages and history screens.
+    pages = [ "\n".join(strings[i:i + args.pages]) for i in range(0, len(strings), args.pages) ]
+
+    for name, data in [ ("strings", strings), ("pages", pages) ]:
+
+        for s in data:
+            if textsupport.tokenize(s) != reference(s):
+                raise Exception("tokenize({!r}) does not match the reference.".format(s))
+
+        size = sum(len(s) for s in data)
+
+        native = measure(textsupport.tokenize, data, args.runs)
+        python = measure(reference, data, args.runs)
+
+        print("{} {}, {:.1f}k characters:".format(len(data), name, size / 1000.0))
+        print("    tokenize  {:8.2f} ms {:8.1f} M characters/s".format(native * 1000, size / native / 1000000.0))
+        print("    reference {:8.2f} ms {:8.1f} M characters/s".format(python * 1000, size / python / 1000000.0))
+
+
+if __name__ == "__main__":
+    main()
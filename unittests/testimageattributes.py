@@ -0,0 +1,301 @@
+#@PydevCodeAnalysisIgnore
+import collections
+import itertools
+import unittest
+
+import renpy
+renpy.import_all()
+import renpy.display.image as image
+
+
+class Chooser(object):
+    """
+    An image that chooses its own attributes, like a layered image, with
+    at most one attribute from each group.
+    """
+
+    def __init__(self, *groups):
+        self.groups = groups
+
+    def group(self, attribute):
+        for i, g in enumerate(self.groups):
+            if attribute in g:
+                return i
+
+        return None
+
+    def _choose_attributes(self, tag, required, optional):
+
+        rv = [ ]
+        used = set()
+
+        for a in required:
+            g = self.group(a)
+
+            if (g is None) or (g in used):
+                return None
+
+            used.add(g)
+            rv.append(a)
+
+        for a in optional or ():
+            g = self.group(a)
+
+            if (g is not None) and (g not in used):
+                used.add(g)
+                rv.append(a)
+
+        return tuple(rv)
+
+
+# Linear scans over every image with a tag, used to check the results
+# that use the attribute index.
+
+def linear_get_available_image_attributes(tag, attributes=()):
+
+    rv = [ ]
+
+    if tag not in image.image_attributes:
+        return rv
+
+    for at in image.image_attributes[tag]:
+        for a in attributes:
+            if a not in at:
+                break
+        else:
+            rv.append(at)
+
+    return rv
+
+
+def linear_check_image_attributes(tag, attributes):
+
+    negative = tuple(i for i in attributes if i[:1] == "-")
+    attributes = [i for i in attributes if i[:1] != "-"]
+
+    l = [ ]
+
+    for attrs, d in image.image_attributes[tag].items():
+
+        remainder = [ i for i in attributes if i not in attrs ]
+
+        ca = getattr(d, "_choose_attributes", None)
+
+        if ca is not None:
+
+            chosen = ca(tag, remainder, None)
+            if chosen is not None:
+                l.append(attrs + tuple(chosen))
+
+        else:
+
+            if not remainder:
+                l.append(attrs)
+
+    if negative:
+        negated = {i[1:] for i in negative}
+        l = [ i for i in l if not (negated & set(i)) ]
+
+    for i in l:
+        if len(i) == len(attributes):
+            return tuple(i + negative)
+
+    if len(l) != 1:
+        return None
+
+    return tuple(l[0] + negative)
+
+
+def linear_choose_image(tag, required, optional, exception_name):
+
+    max_len = -1
+    matches = None
+
+    for attrs, d in image.image_attributes[tag].items():
+
+        if not all((i in required) or (i in optional) for i in attrs):
+            continue
+
+        ca = getattr(d, "_choose_attributes", None)
+
+        if ca:
+            ca_required = [ i for i in required if i not in attrs ]
+            ca_optional = [ i for i in optional if i not in attrs if i not in required ]
+
+            newattrs = ca(tag, ca_required, ca_optional)
+
+            if newattrs is None:
+                continue
+
+            attrs = attrs + newattrs
+
+        else:
+
+            num_required = 0
+
+            for i in attrs:
+                if i in required:
+                    num_required += 1
+
+            if num_required != len(required):
+                continue
+
+        len_attrs = len(set(attrs))
+
+        if len_attrs < max_len:
+            continue
+
+        if len_attrs > max_len:
+            max_len = len_attrs
+            matches = [ ]
+
+        matches.append((tag,) + attrs)
+
+    if matches is None:
+        return None
+
+    if len(matches) == 1:
+        return matches[0]
+
+    if exception_name:
+        raise Exception("Showing '" + " ".join(exception_name) + "' is ambiguous, possible images include: " + ", ".join(" ".join(i) for i in matches))
+    else:
+        return None
+
+
+def outcome(f, *args):
+    """
+    Returns the result of calling `f`, or the message of the exception it
+    raises.
+    """
+
+    try:
+        return ("result", f(*args))
+    except Exception as e:
+        return ("exception", str(e))
+
+
+class TestImageAttributes(unittest.TestCase):
+
+    def setUp(self):
+        self.old_state = (image.images, image.image_attributes, image.attribute_indexes, image.image_names)
+
+        image.images = { }
+        image.image_attributes = collections.defaultdict(dict)
+        image.attribute_indexes = { }
+        image.image_names = [ ]
+
+        # Plain images, including some that are ambiguous.
+        for name in [
+                "eileen",
+                "eileen happy",
+                "eileen sad",
+                "eileen happy beach",
+                "eileen sad beach",
+                "eileen beach night",
+                "eileen night beach",
+                "eileen happy night",
+                ]:
+
+            image.register_image(tuple(name.split()), object())
+
+        # A mix of plain images and images that choose attributes.
+        image.register_image(("lucy",), Chooser(("happy", "sad"), ("casual", "formal")))
+        image.register_image(("lucy", "formal", "happy"), object())
+        image.register_image(("lucy", "beach"), object())
+        image.register_image(("lucy", "beach", "sad"), Chooser(("casual", "formal")))
+
+        # Only images that choose attributes.
+        image.register_image(("bob",), Chooser(("happy", "sad")))
+        image.register_image(("bob", "side"), Chooser(("happy", "sad"), ("casual",)))
+
+        self.info = image.ShownImageInfo()
+
+    def tearDown(self):
+        image.images, image.image_attributes, image.attribute_indexes, image.image_names = self.old_state
+
+    def vocabulary(self, tag):
+        rv = set([ "unknown" ])
+
+        for attrs, d in image.image_attributes[tag].items():
+            rv.update(attrs)
+
+            if isinstance(d, Chooser):
+                for g in d.groups:
+                    rv.update(g)
+
+        return sorted(rv)
+
+    def attribute_lists(self, tag, size):
+        vocabulary = self.vocabulary(tag)
+
+        for n in range(size + 1):
+            for i in itertools.permutations(vocabulary, n):
+                yield i
+
+    def check_tag(self, tag):
+
+        for attributes in self.attribute_lists(tag, 3):
+
+            assert image.get_available_image_attributes(tag, attributes) == linear_get_available_image_attributes(tag, attributes), attributes
+
+            assert image.check_image_attributes(tag, attributes) == linear_check_image_attributes(tag, attributes), attributes
+
+            for negative in attributes[-1:]:
+                query = attributes[:-1] + ("-" + negative,)
+                assert image.check_image_attributes(tag, query) == linear_check_image_attributes(tag, query), query
+
+        for required in self.attribute_lists(tag, 2):
+            for optional in self.attribute_lists(tag, 2):
+
+                for exception_name in [ None, (tag,) + required ]:
+
+                    new = outcome(self.info.choose_image, tag, required, optional, exception_name)
+                    old = outcome(linear_choose_image, tag, required, optional, exception_name)
+
+                    assert new == old, (required, optional, exception_name)
+
+    def test_plain(self):
+        self.check_tag("eileen")
+
+    def test_mixed(self):
+        self.check_tag("lucy")
+
+    def test_choosers(self):
+        self.check_tag("bob")
+
+    def test_ambiguous(self):
+
+        optional = ("happy", "sad", "night")
+
+        with self.assertRaisesRegex(Exception, "is ambiguous"):
+            self.info.choose_image("eileen", ("beach",), optional, ("eileen", "beach"))
+
+        assert self.info.choose_image("eileen", ("beach",), optional, None) is None
+
+        new = outcome(self.info.choose_image, "eileen", ("beach",), optional, ("eileen", "beach"))
+        old = outcome(linear_choose_image, "eileen", ("beach",), optional, ("eileen", "beach"))
+
+        assert new == old
+
+    def test_unknown_tag(self):
+        assert image.get_available_image_attributes("nobody") == [ ]
+
+    def test_register_invalidates(self):
+
+        assert image.check_image_attributes("eileen", ("angry",)) is None
+        assert "eileen" in image.attribute_indexes
+
+        ordered = image.get_ordered_image_attributes("eileen")
+        assert "angry" not in ordered
+
+        image.register_image(("eileen", "angry"), object())
+
+        assert "eileen" not in image.attribute_indexes
+
+        assert image.check_image_attributes("eileen", ("angry",)) == ("angry",)
+        assert "angry" in image.get_ordered_image_attributes("eileen")
+        assert ("angry",) in image.get_available_image_attributes("eileen", ("angry",))
+        assert self.info.choose_image("eileen", ("angry",), (), None) == ("eileen", "angry")
+
+        self.check_tag("eileen")
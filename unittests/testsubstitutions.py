@@ -0,0 +1,142 @@
+#@PydevCodeAnalysisIgnore
+import string
+import unittest
+import unittest.mock
+
+import renpy
+renpy.import_all()
+from renpy.substitutions import formatter, get_template
+
+
+class Thing(object):
+
+    def __init__(self, **kwargs):
+        self.__dict__.update(kwargs)
+
+
+def compiled(s, kwargs):
+    """
+    Formats `s` with the compiled Template.
+    """
+
+    t = get_template(s)
+    assert t is not None, s
+    return t.format(kwargs)
+
+
+def uncompiled(s, kwargs):
+    """
+    Formats `s` with string.Formatter, bypassing the Template.
+    """
+
+    return string.Formatter.vformat(formatter, s, (), kwargs)
+
+
+class TestSubstitutions(unittest.TestCase):
+
+    def setUp(self):
+        self.scope = {
+            "name" : "Eileen",
+            "n" : 42,
+            "f" : 3.14159,
+            "braces" : "{b}bold{/b}",
+            "thing" : Thing(name="Lucy", child=Thing(age=7)),
+            "d" : { "key" : "value", 0 : "zero", "thing" : Thing(name="Bob") },
+            "l" : [ "first", "second" ],
+            "inner" : "[name]",
+            }
+
+    def check_same(self, s):
+        assert compiled(s, self.scope) == uncompiled(s, self.scope), s
+
+    def check_same_error(self, s, exception):
+
+        with self.assertRaises(exception):
+            uncompiled(s, self.scope)
+
+        with self.assertRaises(exception):
+            formatter.vformat(s, (), self.scope)
+
+    def test_literal(self):
+        self.check_same("Hello, world.")
+        self.check_same("Escaped [[name].")
+        self.check_same("")
+
+    def test_names(self):
+        self.check_same("[name]")
+        self.check_same("Hello, [name], [n] times.")
+
+    def test_attributes_and_items(self):
+        self.check_same("[thing.name]")
+        self.check_same("[thing.child.age]")
+        self.check_same("[d[key]]")
+        self.check_same("[d[0]]")
+        self.check_same("[d[thing].name]")
+        self.check_same("[l[1]]")
+
+        assert compiled("[thing.child.age] [d[thing].name]", self.scope) == "7 Bob"
+
+    def test_format_spec(self):
+        self.check_same("[n:05d]")
+        self.check_same("[f:.2f]")
+        self.check_same("[name:>10]")
+        self.check_same("[thing.name:^9]")
+
+        assert compiled("[f:.2f]", self.scope) == "3.14"
+
+    def test_conversions(self):
+        self.check_same("[braces!q]")
+        self.check_same("[name!u]")
+        self.check_same("[name!l]")
+        self.check_same("[name!r]")
+        self.check_same("[name!s]")
+        self.check_same("[n!s]")
+        self.check_same("[inner!i]")
+        self.check_same("[inner!iu]")
+        self.check_same("[name:>8!u]")
+        self.check_same("[thing.name:>8!q]")
+
+        assert compiled("[braces!q]", self.scope) == "{{b}bold{{/b}"
+        assert compiled("[inner!i]", self.scope) == "Eileen"
+
+    def test_translate_conversion(self):
+
+        with unittest.mock.patch.object(renpy.translation, "translate_string", lambda s : "<" + s + ">"):
+            self.check_same("[name!t]")
+            self.check_same("[name!tu]")
+
+            assert compiled("[name!t]", self.scope) == "<Eileen>"
+
+    def test_fallback(self):
+
+        # Positional fields aren't compiled.
+        assert get_template("[0]") is None
+        assert formatter.vformat("[0] and [1]", ("a", "b"), { }) == "a and b"
+
+        # Fields with an empty name aren't compiled.
+        assert get_template("[.name]") is None
+
+        # Format specs with fields of their own aren't compiled.
+        assert get_template("[n:[w]]") is None
+
+        # Invalid conversions aren't compiled, so string.Formatter reports
+        # the error.
+        assert get_template("[name!z]") is None
+
+    def test_errors(self):
+        self.check_same_error("[missing]", KeyError)
+        self.check_same_error("[thing.missing]", AttributeError)
+        self.check_same_error("[d[missing]]", KeyError)
+        self.check_same_error("[l[5]]", IndexError)
+        self.check_same_error("[n:q]", ValueError)
+        self.check_same_error("[name!z]", ValueError)
+        self.check_same_error("[name!]", ValueError)
+        self.check_same_error("[.name]", KeyError)
+
+        with self.assertRaisesRegex(Exception, "open format operation"):
+            get_template("[name")
+
+    def test_cache(self):
+        assert get_template("[name]") is get_template("[name]")
+        assert get_template("[0]") is None
+        assert get_template("[0]") is None
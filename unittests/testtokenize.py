@@ -0,0 +1,95 @@
+#@PydevCodeAnalysisIgnore
+import unittest
+
+import renpy
+renpy.import_all()
+from renpy.text.textsupport import tokenize, lenticular_bracket_ruby, TEXT, TAG, PARAGRAPH
+
+
+class TestTokenize(unittest.TestCase):
+
+    def setUp(self):
+        self.old_ruby = renpy.config.lenticular_bracket_ruby
+        renpy.config.lenticular_bracket_ruby = True
+
+    def tearDown(self):
+        renpy.config.lenticular_bracket_ruby = self.old_ruby
+
+    def test_plain(self):
+        assert tokenize(u"") == [ ]
+        assert tokenize(u"Hello, world.") == [ (TEXT, u"Hello, world.") ]
+
+    def test_tags(self):
+        assert tokenize(u"a{b}c{/b}d") == [
+            (TEXT, u"a"), (TAG, u"b"), (TEXT, u"c"), (TAG, u"/b"), (TEXT, u"d") ]
+
+        assert tokenize(u"{size=+10}{color=#f00}x") == [
+            (TAG, u"size=+10"), (TAG, u"color=#f00"), (TEXT, u"x") ]
+
+    def test_escaped_brace(self):
+        assert tokenize(u"a{{b") == [ (TEXT, u"a{b") ]
+        assert tokenize(u"{{") == [ (TEXT, u"{") ]
+        assert tokenize(u"a{{") == [ (TEXT, u"a{") ]
+        assert tokenize(u"{{{{") == [ (TEXT, u"{{") ]
+        assert tokenize(u"{b}{{x") == [ (TAG, u"b"), (TEXT, u"{x") ]
+        assert tokenize(u"a{{b}c") == [ (TEXT, u"a{b}c") ]
+
+    def test_brace_at_end(self):
+        for s in [ u"{", u"a{", u"{b", u"a{b}c{" ]:
+            with self.assertRaisesRegex(Exception, "Open text tag at end of string"):
+                tokenize(s)
+
+    def test_empty_tag(self):
+        for s in [ u"{}", u"a{}b" ]:
+            with self.assertRaisesRegex(Exception, "Empty text tag"):
+                tokenize(s)
+
+    def test_paragraphs(self):
+        assert tokenize(u"\n") == [ (PARAGRAPH, u"") ]
+
+        assert tokenize(u"a\n{b}c\n") == [
+            (TEXT, u"a"), (PARAGRAPH, u""), (TAG, u"b"), (TEXT, u"c"), (PARAGRAPH, u"") ]
+
+        assert tokenize(u"a\n\nb") == [
+            (TEXT, u"a"), (PARAGRAPH, u""), (PARAGRAPH, u""), (TEXT, u"b") ]
+
+    def test_newline_in_tag(self):
+        assert tokenize(u"{b\n}x{/b}") == [ (TAG, u"b\n"), (TEXT, u"x"), (TAG, u"/b") ]
+
+    def test_ruby(self):
+
+        ruby = [
+            (TAG, u"rb"), (TEXT, u"東京"), (TAG, u"/rb"),
+            (TAG, u"rt"), (TEXT, u"とうきょう"), (TAG, u"/rt"),
+            ]
+
+        assert tokenize(u"【東京｜とうきょう】") == ruby
+        assert tokenize(u"【東京|とうきょう】b") == ruby + [ (TEXT, u"b") ]
+        assert tokenize(u"a{{【東京｜とうきょう】") == [ (TEXT, u"a{") ] + ruby
+
+        renpy.config.lenticular_bracket_ruby = False
+        assert tokenize(u"【東京｜とうきょう】") == [ (TEXT, u"【東京｜とうきょう】") ]
+
+    def test_doubled_bracket(self):
+        assert tokenize(u"【【x】") == [ (TEXT, u"【x】") ]
+        assert tokenize(u"x【【") == [ (TEXT, u"x"), (TEXT, u"【") ]
+
+        assert tokenize(u"【【【a｜b】") == [
+            (TEXT, u"【"),
+            (TAG, u"rb"), (TEXT, u"a"), (TAG, u"/rb"),
+            (TAG, u"rt"), (TEXT, u"b"), (TAG, u"/rt"),
+            ]
+
+    def test_unterminated_bracket(self):
+        assert tokenize(u"【】") == [ (TEXT, u"【】") ]
+        assert tokenize(u"【a") == [ (TEXT, u"【a") ]
+        assert tokenize(u"【a\nb") == [ (TEXT, u"【a"), (PARAGRAPH, u""), (TEXT, u"b") ]
+
+        assert tokenize(u"【a|b") == [
+            (TAG, u"rb"), (TEXT, u"a"), (TAG, u"/rb"),
+            (TAG, u"rt"), (TEXT, u"b"), (TAG, u"/rt"),
+            ]
+
+    def test_lenticular_bracket_ruby(self):
+        assert lenticular_bracket_ruby(u"a") == [ (TEXT, u"a") ]
+        assert lenticular_bracket_ruby(u"a【b") == [ (TEXT, u"a"), (TEXT, u"【b") ]